@@ -7,6 +7,7 @@
 #include "godot_cpp/variant/packed_byte_array.hpp"
 #include "multiplex_packet.h"
 #include "multiplex_peer.h"
+#include "steam_trace.h"
 
 using namespace godot;
 
@@ -58,6 +59,7 @@ Error MultiplexNetwork::disconnect_peer(int32_t mux_peer_id, bool force) {
 }
 
 void MultiplexNetwork::poll() {
+	STEAM_TRACE_ZONE("MultiplexNetwork::poll");
 	this->interface->poll();
 	for (int i = 0; i < this->interface->get_available_packet_count(); i++) {
 		int32_t sender_pid = this->interface->get_packet_peer();
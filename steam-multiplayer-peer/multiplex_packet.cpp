@@ -1,4 +1,6 @@
 #include "multiplex_packet.h"
+#include "steam_memory_stats.h"
+#include "steam_trace.h"
 #include <endian.h>
 #include "godot_cpp/classes/global_constants.hpp"
 #include "godot_cpp/classes/multiplayer_peer.hpp"
@@ -7,7 +9,13 @@
 
 using namespace godot;
 
+MultiplexPacket::MultiplexPacket() {
+  SteamMemoryStats::add(SteamMemoryStats::live_multiplex_packets, 1);
+  SteamMemoryStats::packet_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
 MultiplexPacket::~MultiplexPacket() {
+  SteamMemoryStats::add(SteamMemoryStats::live_multiplex_packets, -1);
   if (subtype == MUX_DATA) {
     ::free(contents.data.data);
   }
@@ -15,6 +23,7 @@ MultiplexPacket::~MultiplexPacket() {
 
 
 PackedByteArray MultiplexPacket::serialize() {
+  STEAM_TRACE_ZONE("MultiplexPacket::serialize");
   PackedByteArray out;
   if (subtype == MUX_DATA) {
     out.resize(14 + sizeof(uint8_t) * contents.data.length);
@@ -36,10 +45,13 @@ PackedByteArray MultiplexPacket::serialize() {
     out.encode_u8 (2, (uint8_t)contents.command.subtype);
     out.encode_s32(3, htobe32((int32_t)contents.command.subject_multiplex_peer));
   }
+  STEAM_TRACE_VALUE(out.size());
   return out;
 }
 
 Error MultiplexPacket::deserialize(PackedByteArray& rawData) {
+  STEAM_TRACE_ZONE("MultiplexPacket::deserialize");
+  STEAM_TRACE_VALUE(rawData.size());
   subtype = (MultiplexPacketSubtype)(uint8_t)rawData.decode_u8(0);
   transfer_mode = (MultiplayerPeer::TransferMode)(uint8_t)rawData.decode_u8(1);
   switch (subtype) {
@@ -69,6 +69,7 @@ public:
 		MultiplexPacketData data;
 	} contents;
 
+  MultiplexPacket();
   ~MultiplexPacket();
 	// converts a multiplex packet into a newly allocated byte buffer in network order, returns length
   godot::PackedByteArray serialize();
@@ -5,6 +5,7 @@
 #include "godot_cpp/core/error_macros.hpp"
 #include "multiplex_network.h"
 #include "multiplex_packet.h"
+#include "steam_memory_stats.h"
 #include "steam_packet_peer.h"
 #include <godot_cpp/variant/utility_functions.hpp>
 
@@ -18,6 +19,14 @@ MultiplexPeer::~MultiplexPeer() {
 	if (active_mode != MODE_NONE) {
 		this->close();
 	}
+	_clear_incoming();
+}
+
+void MultiplexPeer::_clear_incoming() {
+	for (const List<Ref<MultiplexPacket>>::Element *E = incoming_packets.front(); E; E = E->next()) {
+		SteamMemoryStats::add(SteamMemoryStats::multiplex_queue_bytes, -(int64_t)E->get()->contents.data.length);
+	}
+	incoming_packets.clear();
 }
 Error MultiplexPeer::create_server(Ref<MultiplexNetwork> network) {
 	this->active_mode = MultiplexPeer::Mode::MODE_SERVER;
@@ -38,6 +47,7 @@ Error MultiplexPeer::_get_packet(const uint8_t **r_buffer, int32_t *r_buffer_siz
 
 	current_packet = incoming_packets.front()->get();
 	incoming_packets.pop_front();
+	SteamMemoryStats::add(SteamMemoryStats::multiplex_queue_bytes, -(int64_t)current_packet->contents.data.length);
 
 	*r_buffer = current_packet->contents.data.data;
 	*r_buffer_size = current_packet->contents.data.length;
@@ -115,7 +125,7 @@ void MultiplexPeer::_close() {
 	packet->contents.data.mux_peer_dest = 1;
 	packet->contents.command.subject_multiplex_peer = this->_get_unique_id();
 	packet->contents.command.subtype = MUX_CMD_REMOVE_PEER;
-	incoming_packets.clear();
+	_clear_incoming();
 	this->network->send(packet, 1, 0, TRANSFER_MODE_RELIABLE);
 	this->active_mode = MODE_NONE;
 	this->network->_remove_mux_peer(this);
@@ -144,6 +154,7 @@ bool MultiplexPeer::_is_server_relay_supported() const {
 
 Error MultiplexPeer::_put_multiplex_packet_direct(Ref<MultiplexPacket> packet) {
 	this->incoming_packets.push_back(packet);
+	SteamMemoryStats::add(SteamMemoryStats::multiplex_queue_bytes, packet->contents.data.length);
 	return OK;
 }
 
@@ -54,6 +54,7 @@ private:
 	int32_t max_subpeers = 0;
 	MultiplayerPeer::ConnectionStatus connection_status = CONNECTION_DISCONNECTED;
 	MultiplayerPeer::TransferMode current_transfer_mode = TRANSFER_MODE_RELIABLE;
+	void _clear_incoming();
 
 protected:
   static void _bind_methods();
@@ -11,7 +11,14 @@
 #include "steam_connection.h"
 #include "steam_multiplayer_peer.h"
 #include "steam_packet_peer.h"
+#include "steam_packet_reader.h"
+#include "steam_packet_writer.h"
 #include "steam_peer_config.h"
+#include "steam_snapshot_codec.h"
+
+#ifdef STEAM_PEER_TESTS
+#include "steam_peer_tests.h"
+#endif
 
 using namespace godot;
 
@@ -21,8 +28,14 @@ void initialize_steam_multiplayer_peer(ModuleInitializationLevel level) {
 		ClassDB::register_class<SteamPacketPeer>();
 		ClassDB::register_class<SteamConnection>();
 		ClassDB::register_class<SteamMultiplayerPeer>();
+		ClassDB::register_class<SteamPacketWriter>();
+		ClassDB::register_class<SteamPacketReader>();
+		ClassDB::register_class<SteamSnapshotCodec>();
     ClassDB::register_class<MultiplexPeer>();
     ClassDB::register_class<MultiplexNetwork>();
+#ifdef STEAM_PEER_TESTS
+		ClassDB::register_class<SteamPeerTests>();
+#endif
 	}
 }
 
@@ -1,4 +1,6 @@
 #include "steam_connection.h"
+#include "steam_memory_stats.h"
+#include "steam_trace.h"
 #include <godot_cpp/variant/utility_functions.hpp>
 
 void SteamConnection::_bind_methods() {
@@ -10,11 +12,36 @@ EResult SteamConnection::_raw_send(Ref<SteamPacketPeer> packet) {
 
 // TODO change to return correct error
 Error SteamConnection::_send_pending() {
+	if (steam_connection == k_HSteamNetConnection_Invalid || pending_retry_packets.size() == 0) {
+		return OK;
+	}
+	STEAM_TRACE_ZONE("SteamConnection::_send_pending");
+	STEAM_TRACE_VALUE(pending_retry_packets.size());
+
+	int64_t budget = INT64_MAX;
+	if (max_pending_bytes > 0) {
+		SteamNetConnectionRealTimeStatus_t status;
+		if (SteamNetworkingSockets()->GetConnectionRealTimeStatus(steam_connection, &status, 0, nullptr) == k_EResultOK) {
+			budget = (int64_t)max_pending_bytes - status.m_cbPendingReliable - status.m_cbPendingUnreliable;
+		}
+	}
+	if (expiring_packets > 0) {
+		_drop_expired();
+	}
+
 	while (pending_retry_packets.size() > 0) {
 		Ref<SteamPacketPeer> packet = pending_retry_packets.front()->get();
+		if (budget <= 0) {
+			break;
+			//Steam already holds enough, release the rest on a later poll
+		}
 		EResult errorCode = _raw_send(packet);
 		if (errorCode == k_EResultOK) {
-			pending_retry_packets.pop_front();
+			if (packet->queued_at != 0) {
+				send_latency[packet->channel].record(SteamNetworkingUtils()->GetLocalTimestamp() - packet->queued_at);
+			}
+			budget -= packet->size;
+			_erase_pending(pending_retry_packets.front());
 		} else {
 			String errorString = _convert_eresult_to_string(errorCode);
 			if (packet->transfer_mode & k_nSteamNetworkingSend_Reliable) { //comparison to ensure inclusion
@@ -23,7 +50,7 @@ Error SteamConnection::_send_pending() {
 				//break, retry send later
 			} else {
 				WARN_PRINT(String("Send Error (Unreliable, won't retry): ") + errorString);
-				pending_retry_packets.pop_front();
+				_erase_pending(pending_retry_packets.front());
 				//toss unreliable packet, move on
 			}
 		}
@@ -32,12 +59,98 @@ Error SteamConnection::_send_pending() {
 	return OK;
 }
 
-void SteamConnection::_add_packet(Ref<SteamPacketPeer> packet) {
-	pending_retry_packets.push_back(packet);
+// The whole queue, not just up to where the budget runs out, so expired packets behind
+// the budget don't hold memory or count as pending.
+void SteamConnection::_drop_expired() {
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	List<Ref<SteamPacketPeer>>::Element *E = pending_retry_packets.front();
+	while (E && expiring_packets > 0) {
+		List<Ref<SteamPacketPeer>>::Element *next = E->next();
+		if (_can_expire(E->get()) && now > E->get()->deadline) {
+			_erase_pending(E);
+			expired_packets++;
+		}
+		E = next;
+	}
+}
+
+void SteamConnection::_erase_pending(List<Ref<SteamPacketPeer>>::Element *E) {
+	if (_can_expire(E->get())) {
+		expiring_packets--;
+	}
+	uint64_t key = E->get()->key;
+	if (key != 0) {
+		HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *> &keys = _get_pending_keys(E->get());
+		HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *>::Iterator K = keys.find(key);
+		if (K && K->value == E) {
+			keys.remove(K);
+		}
+	}
+	E->erase();
+}
+
+// Keeps the queue ordered by priority, FIFO among packets of equal priority. A keyed packet
+// replaces a queued packet with the same key and reliability, so only the newest value is
+// sent. It keeps the old packet's place unless its priority differs.
+void SteamConnection::enqueue(Ref<SteamPacketPeer> packet) {
+	HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *> &keys = _get_pending_keys(packet);
+	if (packet->key != 0) {
+		HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *>::Iterator K = keys.find(packet->key);
+		if (K) {
+			collapsed_packets++;
+			if (K->value->get()->priority != packet->priority) {
+				_erase_pending(K->value);
+			} else {
+				if (_can_expire(K->value->get())) {
+					expiring_packets--;
+				}
+				if (_can_expire(packet)) {
+					expiring_packets++;
+				}
+				K->value->get() = packet;
+				return;
+			}
+		}
+	}
+
+	List<Ref<SteamPacketPeer>>::Element *E = pending_retry_packets.back();
+	while (E && E->get()->priority < packet->priority) {
+		E = E->prev();
+	}
+	if (E) {
+		E = pending_retry_packets.insert_after(E, packet);
+	} else {
+		E = pending_retry_packets.push_front(packet);
+	}
+	if (packet->key != 0) {
+		keys[packet->key] = E;
+	}
+	if (_can_expire(packet)) {
+		expiring_packets++;
+	}
+}
+
+// Unreliable packets would be stale by the time a parked connection is back.
+void SteamConnection::drop_unreliable_pending() {
+	List<Ref<SteamPacketPeer>>::Element *E = pending_retry_packets.front();
+	while (E) {
+		List<Ref<SteamPacketPeer>>::Element *next = E->next();
+		if (!(E->get()->transfer_mode & k_nSteamNetworkingSend_Reliable)) {
+			_erase_pending(E);
+		}
+		E = next;
+	}
 }
 
 Error SteamConnection::send(Ref<SteamPacketPeer> packet) {
-	_add_packet(packet);
+	if (is_parked() && !(packet->transfer_mode & k_nSteamNetworkingSend_Reliable)) {
+		return OK;
+	}
+	enqueue(packet);
+	return _send_pending();
+}
+
+Error SteamConnection::resend_pending() {
 	return _send_pending();
 }
 
@@ -66,13 +179,19 @@ bool SteamConnection::operator==(const SteamConnection &other) {
 	return steam_id == other.steam_id;
 }
 
+SteamConnection::SteamConnection() {
+	SteamMemoryStats::add(SteamMemoryStats::live_connections, 1);
+}
+
 SteamConnection::SteamConnection(uint64_t steam_id) {
+	SteamMemoryStats::add(SteamMemoryStats::live_connections, 1);
 	this->peer_id = -1;
 	this->steam_id = steam_id;
 	this->last_msg_timestamp = 0;
 }
 
 SteamConnection::~SteamConnection() {
+	SteamMemoryStats::add(SteamMemoryStats::live_connections, -1);
 	SteamNetworkingSockets()->CloseConnection(this->steam_connection, ESteamNetConnectionEnd::k_ESteamNetConnectionEnd_App_Generic, "Disconnect Default!", true);
 	while (pending_retry_packets.size()) {
 		Ref<SteamPacketPeer> p = pending_retry_packets.front()->get();
@@ -80,22 +199,6 @@ SteamConnection::~SteamConnection() {
 	}
 }
 
-Error SteamConnection::request_peer() {
-	SetupPeerPayload payload = SetupPeerPayload();
-	return _send_setup_peer(payload);
-}
-
-Error SteamConnection::send_peer(uint32_t peer_id) {
-	SteamConnection::SetupPeerPayload payload = SteamConnection::SetupPeerPayload();
-	payload.peer_id = peer_id;
-	return _send_setup_peer(payload);
-}
-
-Error SteamConnection::_send_setup_peer(const SetupPeerPayload payload) {
-	Ref<SteamPacketPeer> packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer((void *)&payload, sizeof(SetupPeerPayload), MultiplayerPeer::TRANSFER_MODE_RELIABLE)));
-	return send(packet);
-}
-
 // Long but simple: just return the type of the EResult as a Godot String
 String SteamConnection::_convert_eresult_to_string(EResult e) {
 	switch (e) {
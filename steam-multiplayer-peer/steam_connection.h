@@ -4,8 +4,10 @@
 #include <godot_cpp/classes/multiplayer_peer_extension.hpp>
 #include <godot_cpp/classes/ref_counted.hpp>
 #include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
 #include <memory>
 
+#include "steam_histogram.h"
 #include "steam_packet_peer.h"
 
 #define MAX_STEAM_PACKET_SIZE k_cbMaxSteamNetworkingSocketsMessageSizeSend
@@ -15,9 +17,6 @@ using namespace godot;
 class SteamConnection : public RefCounted {
 	GDCLASS(SteamConnection, RefCounted)
 public:
-	struct SetupPeerPayload {
-		uint32_t peer_id = -1;
-	};
 	bool m_bActive; // Is this slot in use? Or is it available for new connections?
 	uint64_t steam_id; // What is the steamid of the player?
 	HSteamNetConnection steam_connection; // The handle for the connection to the player
@@ -25,13 +24,36 @@ public:
 	int peer_id;
 	uint64_t last_msg_timestamp;
 	List<Ref<SteamPacketPeer>> pending_retry_packets;
+	// Adaptive rate controller state, see SteamMultiplayerPeer::_update_adaptive_rates.
+	float update_rate = 1.0;
+	int32_t send_rate_max = 0;
+	// Set while the connection is parked for a fast reconnect. The handle is invalid in
+	// that state, reliable packets keep queueing and unreliable ones are dropped.
+	uint64_t parked_since = 0;
+	// Bytes Steam may hold unsent for this connection before the scheduler stops releasing
+	// packets to it. 0 hands every packet to Steam immediately.
+	int32_t max_pending_bytes = 0;
+	uint64_t expired_packets = 0;
+	uint64_t collapsed_packets = 0;
+	// Time from put_packet to Steam accepting the packet, per channel. Only packets stamped
+	// with queued_at are recorded.
+	HashMap<uint16_t, SteamHistogram> send_latency;
 
 private:
 	EResult _raw_send(Ref<SteamPacketPeer> packet);
 	String _convert_eresult_to_string(EResult e);
 	Error _send_pending();
-	void _add_packet(Ref<SteamPacketPeer> packet);
-	Error _send_setup_peer(const SetupPeerPayload payload);
+	// Keys are scoped per reliability, an unreliable packet never replaces a reliable one.
+	HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *> pending_by_key;
+	HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *> pending_reliable_by_key;
+	_FORCE_INLINE_ HashMap<uint64_t, List<Ref<SteamPacketPeer>>::Element *> &_get_pending_keys(const Ref<SteamPacketPeer> &p_packet) {
+		return (p_packet->transfer_mode & k_nSteamNetworkingSend_Reliable) ? pending_reliable_by_key : pending_by_key;
+	}
+	// Queued packets that carry a deadline, so _send_pending skips the sweep when there are none.
+	uint32_t expiring_packets = 0;
+	_FORCE_INLINE_ static bool _can_expire(const Ref<SteamPacketPeer> &p_packet) { return p_packet->deadline != 0 && !(p_packet->transfer_mode & k_nSteamNetworkingSend_Reliable); }
+	void _drop_expired();
+	void _erase_pending(List<Ref<SteamPacketPeer>>::Element *E);
 
 protected:
 	static void _bind_methods();
@@ -41,14 +63,15 @@ public:
 	// void broadcast(enet_uint8 p_channel, ENetPacket *p_packet);
 	bool operator==(const SteamConnection &data);
 	Error send(Ref<SteamPacketPeer> packet);
+	void enqueue(Ref<SteamPacketPeer> packet);
+	void drop_unreliable_pending();
+	Error resend_pending();
+	_FORCE_INLINE_ bool is_parked() const { return parked_since != 0; }
 	void flush();
 	bool close();
 	SteamConnection(uint64_t steam_id);
-	SteamConnection() {}
+	SteamConnection();
 	~SteamConnection();
-
-	Error request_peer();
-	Error send_peer(uint32_t peer_id);
 };
 
 #endif // STEAM_CONNECTION_H
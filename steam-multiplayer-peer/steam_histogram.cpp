@@ -0,0 +1,94 @@
+#include "steam_histogram.h"
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define BUCKET_COUNT ((64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+uint32_t SteamHistogram::_bucket_of(uint64_t p_value) {
+	if (p_value < SUB_BUCKETS) {
+		return p_value;
+	}
+	uint32_t exponent = 0;
+	while ((p_value >> exponent) > 1) {
+		exponent++;
+	}
+	uint32_t shift = exponent - SUB_BUCKET_BITS;
+	return (shift + 1) * SUB_BUCKETS + ((p_value >> shift) & (SUB_BUCKETS - 1));
+}
+
+// Largest value that falls in p_bucket.
+uint64_t SteamHistogram::_bucket_high(uint32_t p_bucket) {
+	if (p_bucket < SUB_BUCKETS) {
+		return p_bucket;
+	}
+	uint32_t shift = p_bucket / SUB_BUCKETS - 1;
+	uint64_t sub = p_bucket % SUB_BUCKETS;
+	return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void SteamHistogram::record(uint64_t p_value) {
+	if (buckets.size() == 0) {
+		buckets.resize(BUCKET_COUNT);
+		memset(buckets.ptr(), 0, BUCKET_COUNT * sizeof(uint32_t));
+	}
+	buckets[_bucket_of(p_value)]++;
+	count++;
+	total += p_value;
+	min = MIN(min, p_value);
+	max = MAX(max, p_value);
+}
+
+uint64_t SteamHistogram::percentile(double p_fraction) const {
+	if (count == 0) {
+		return 0;
+	}
+	uint64_t rank = MAX((uint64_t)1, (uint64_t)(p_fraction * count + 0.5));
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < buckets.size(); i++) {
+		seen += buckets[i];
+		if (seen >= rank) {
+			return MIN(_bucket_high(i), max);
+		}
+	}
+	return max;
+}
+
+void SteamHistogram::merge(const SteamHistogram &p_other) {
+	if (p_other.count == 0) {
+		return;
+	}
+	if (buckets.size() == 0) {
+		buckets.resize(BUCKET_COUNT);
+		memset(buckets.ptr(), 0, BUCKET_COUNT * sizeof(uint32_t));
+	}
+	for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+		buckets[i] += p_other.buckets[i];
+	}
+	count += p_other.count;
+	total += p_other.total;
+	min = MIN(min, p_other.min);
+	max = MAX(max, p_other.max);
+}
+
+void SteamHistogram::reset() {
+	if (buckets.size() > 0) {
+		memset(buckets.ptr(), 0, BUCKET_COUNT * sizeof(uint32_t));
+	}
+	count = 0;
+	total = 0;
+	min = UINT64_MAX;
+	max = 0;
+}
+
+Dictionary SteamHistogram::to_dictionary() const {
+	Dictionary result;
+	result["count"] = count;
+	result["min"] = count > 0 ? min : 0;
+	result["max"] = max;
+	result["mean"] = count > 0 ? (double)total / count : 0.0;
+	result["p50"] = percentile(0.5);
+	result["p90"] = percentile(0.9);
+	result["p99"] = percentile(0.99);
+	result["p999"] = percentile(0.999);
+	return result;
+}
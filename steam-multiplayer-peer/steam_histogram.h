@@ -0,0 +1,32 @@
+#ifndef STEAM_HISTOGRAM_H
+#define STEAM_HISTOGRAM_H
+
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+
+using namespace godot;
+
+// Log-linear histogram in the style of HDR histograms: 16 buckets per power of two, so any
+// recorded value is reported within 1/16 of its magnitude. Recording is O(1) and allocation
+// free after the first sample.
+class SteamHistogram {
+	LocalVector<uint32_t> buckets;
+	uint64_t count = 0;
+	uint64_t total = 0;
+	uint64_t min = UINT64_MAX;
+	uint64_t max = 0;
+
+	static uint32_t _bucket_of(uint64_t p_value);
+	static uint64_t _bucket_high(uint32_t p_bucket);
+
+public:
+	void record(uint64_t p_value);
+	uint64_t get_count() const { return count; }
+	uint64_t percentile(double p_fraction) const;
+	void merge(const SteamHistogram &p_other);
+	void reset();
+	// count, min, max, mean, p50, p90, p99 and p999.
+	Dictionary to_dictionary() const;
+};
+
+#endif // STEAM_HISTOGRAM_H
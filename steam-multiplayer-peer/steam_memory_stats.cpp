@@ -0,0 +1,7 @@
+#include "steam_memory_stats.h"
+
+std::atomic<int64_t> SteamMemoryStats::live_packet_peers{ 0 };
+std::atomic<int64_t> SteamMemoryStats::live_multiplex_packets{ 0 };
+std::atomic<int64_t> SteamMemoryStats::live_connections{ 0 };
+std::atomic<uint64_t> SteamMemoryStats::packet_allocations{ 0 };
+std::atomic<int64_t> SteamMemoryStats::multiplex_queue_bytes{ 0 };
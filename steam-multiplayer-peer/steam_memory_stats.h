@@ -0,0 +1,24 @@
+#ifndef STEAM_MEMORY_STATS_H
+#define STEAM_MEMORY_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Process wide live-object and queue accounting for the networking layer, see
+// SteamMultiplayerPeer::get_memory_stats. Counters are relaxed atomics, so they are cheap
+// enough to keep on in release builds.
+struct SteamMemoryStats {
+	static std::atomic<int64_t> live_packet_peers;
+	static std::atomic<int64_t> live_multiplex_packets;
+	static std::atomic<int64_t> live_connections;
+	// Packet objects ever constructed, SteamPacketPeer and MultiplexPacket.
+	static std::atomic<uint64_t> packet_allocations;
+	// Payload bytes queued in MultiplexPeer incoming queues.
+	static std::atomic<int64_t> multiplex_queue_bytes;
+
+	static void add(std::atomic<int64_t> &p_counter, int64_t p_delta) {
+		p_counter.fetch_add(p_delta, std::memory_order_relaxed);
+	}
+};
+
+#endif // STEAM_MEMORY_STATS_H
@@ -1,29 +1,44 @@
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/time.hpp>
 #include <godot_cpp/core/class_db.hpp>
 
+#include "steam_memory_stats.h"
 #include "steam_multiplayer_peer.h"
+#include "steam_networking_hub.h"
+#include "steam_trace.h"
 
 #include <godot_cpp/variant/utility_functions.hpp>
 
 #define STEAM_BUFFER_SIZE 255
-
-SteamMultiplayerPeer::SteamMultiplayerPeer() :
-		callback_network_connection_status_changed(this, &SteamMultiplayerPeer::network_connection_status_changed) {
+#define STREAM_HEADER_SIZE 4
+#define JITTER_HEADER_SIZE 4
+#define JITTER_BUFFER_MAX_PACKETS 64
+#define BATCH_RECORD_SIZE 5
+#define RELAY_HEADER_SIZE 4
+#define SPLIT_PART_HEADER_SIZE 6
+#define SPLIT_FALLBACK_MTU 1200
+
+SteamMultiplayerPeer::SteamMultiplayerPeer() {
 	configs = Ref<SteamPeerConfig>(memnew(SteamPeerConfig()));
+	SteamNetworkingHub::register_peer(this);
 }
 
 SteamMultiplayerPeer::~SteamMultiplayerPeer() {
 	if (_is_active()) {
 		close();
 	}
+	if (performance_monitors) {
+		remove_performance_monitors();
+	}
+	SteamNetworkingHub::unregister_peer(this);
 	// memdelete(*config);
 }
 
 Error SteamMultiplayerPeer::_get_packet(const uint8_t **r_buffer, int32_t *r_buffer_size) {
 	ERR_FAIL_COND_V_MSG(incoming_packets.size() == 0, ERR_UNAVAILABLE, "No incoming packets available.");
 
-	//delete next_received_packet;
-	next_received_packet = incoming_packets.front()->get();
-	incoming_packets.pop_front();
+	_pop_incoming_packet();
 
 	*r_buffer = (const uint8_t *)(&next_received_packet->data);
 	*r_buffer_size = next_received_packet->size;
@@ -31,27 +46,207 @@ Error SteamMultiplayerPeer::_get_packet(const uint8_t **r_buffer, int32_t *r_buf
 	return OK;
 }
 
+// Every way of reading a packet goes through here, so the consume delay covers them all.
+// The packet stays referenced by next_received_packet until the next pop.
+const Ref<SteamPacketPeer> &SteamMultiplayerPeer::_pop_incoming_packet() {
+	//delete next_received_packet;
+	next_received_packet = incoming_packets.front()->get();
+	incoming_packets.pop_front();
+	if (collect_histograms) {
+		_get_channel_histograms(next_received_packet->peer_id, next_received_packet->channel).consume_delay.record(SteamNetworkingUtils()->GetLocalTimestamp() - next_received_packet->received_at);
+	}
+	return next_received_packet;
+}
+
 Error SteamMultiplayerPeer::_put_packet(const uint8_t *p_buffer, int32_t p_buffer_size) {
 	ERR_FAIL_COND_V_MSG(!_is_active(), ERR_UNCONFIGURED, "The multiplayer instance isn't currently active.");
 	ERR_FAIL_COND_V_MSG(connection_status != CONNECTION_CONNECTED, ERR_UNCONFIGURED, "The multiplayer instance isn't currently connected to any server or client.");
-	ERR_FAIL_COND_V_MSG(target_peer != 0 && !peerId_to_steamId.has(ABS(target_peer)), ERR_INVALID_PARAMETER, vformat("Invalid target peer: %d", target_peer));
-	ERR_FAIL_COND_V(active_mode == MODE_CLIENT && !peerId_to_steamId.has(1), ERR_BUG);
+	bool relay_client = native_relay && active_mode == MODE_CLIENT && target_group == TARGET_GROUP_NONE;
+	ERR_FAIL_COND_V_MSG(!relay_client && target_group == TARGET_GROUP_NONE && target_peer > 0 && !slot_by_peer_id.has(target_peer), ERR_INVALID_PARAMETER, vformat("Invalid target peer: %d", target_peer));
+	ERR_FAIL_COND_V(active_mode == MODE_CLIENT && !slot_by_peer_id.has(1), ERR_BUG);
+	STEAM_TRACE_ZONE("SteamMultiplayerPeer::_put_packet");
+	STEAM_TRACE_VALUE(p_buffer_size);
 	int transferMode = _get_steam_transfer_flag();
 
-	if (target_peer == 0) {
-		Error returnValue = OK;
-		for (HashMap<uint64_t, Ref<SteamConnection>>::Iterator E = connections_by_steamId64.begin(); E; ++E) {
-			Ref<SteamPacketPeer> packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer(p_buffer, p_buffer_size, transferMode)));
-			Error errorCode = E->value->send(packet);
+	int32_t relay_size = native_relay ? RELAY_HEADER_SIZE : 0;
+	int32_t header_size = _get_stream_header_size(transferMode);
+	int32_t split_size = _get_split_header_size(transferMode);
+	int32_t prefix_size = relay_size + header_size + split_size;
+	uint16_t channel = header_size > 0 ? send_stream : 0;
+	if (prefix_size > 0) {
+		ERR_FAIL_COND_V_MSG(p_buffer_size + prefix_size > MAX_STEAM_PACKET_SIZE, ERR_INVALID_PARAMETER, "Packet too large for its headers.");
+		stream_scratch.resize(p_buffer_size + prefix_size);
+		uint8_t *w = stream_scratch.ptr();
+		if (relay_size > 0) {
+			_write_relay_header(w, relay_client ? target_peer : 1);
+		}
+		if (header_size > 0) {
+			_write_stream_header(w + relay_size, header_size);
+		}
+		if (split_size > 0) {
+			w[relay_size + header_size] = 1; // a single part
+		}
+		memcpy(w + prefix_size, p_buffer, p_buffer_size);
+		if (split_size > 0 && p_buffer_size + prefix_size > _get_split_mtu()) {
+			return _put_split(w, relay_size + header_size, p_buffer_size, transferMode, channel, relay_client);
+		}
+		p_buffer = w;
+		p_buffer_size += prefix_size;
+	}
+	return _route_packet(p_buffer, p_buffer_size, transferMode, channel, relay_client);
+}
+
+// Sends a fully built packet to the current target.
+Error SteamMultiplayerPeer::_route_packet(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, uint16_t p_channel, bool p_relay_client) {
+	if (p_relay_client) {
+		if (mesh) {
+			// Mesh packets always start with a relay header, so this is one of our scratch buffers.
+			return _mesh_put(const_cast<uint8_t *>(p_buffer), p_buffer_size, p_flags, p_channel);
+		}
+		// Everything goes to the host, which routes on the relay header.
+		if (collect_histograms) {
+			_get_channel_histograms(1, p_channel).sent_size.record(p_buffer_size);
+		}
+		return get_connection_by_peer(1)->send(_make_packet(p_buffer, p_buffer_size, p_flags));
+	}
+
+	if (target_group == TARGET_GROUP_NONE && target_peer > 0) {
+		if (collect_histograms) {
+			_get_channel_histograms(target_peer, p_channel).sent_size.record(p_buffer_size);
+		}
+		return get_connection_by_peer(target_peer)->send(_make_packet(p_buffer, p_buffer_size, p_flags));
+	}
+
+	LocalVector<Ref<SteamConnection>> targets;
+	_collect_targets(target_peer, target_group, targets);
+	return _multicast(p_buffer, p_buffer_size, p_flags, targets);
+}
+
+// Bytes of stream header an outgoing packet with these flags carries, see set_stream_coalescing.
+int32_t SteamMultiplayerPeer::_get_stream_header_size(int p_flags) const {
+	if (!stream_coalescing || (p_flags & k_nSteamNetworkingSend_Reliable)) {
+		return 0;
+	}
+	return STREAM_HEADER_SIZE + (send_stream != 0 && send_stream == jitter_stream ? JITTER_HEADER_SIZE : 0);
+}
+
+void SteamMultiplayerPeer::_write_stream_header(uint8_t *w, int32_t p_header_size) {
+	uint16_t sequence = send_stream != 0 ? ++send_stream_sequences[send_stream] : 0;
+	w[0] = send_stream & 0xFF;
+	w[1] = (send_stream >> 8) & 0xFF;
+	w[2] = sequence & 0xFF;
+	w[3] = (sequence >> 8) & 0xFF;
+	if (p_header_size > STREAM_HEADER_SIZE) {
+		uint32_t sent = (uint32_t)SteamNetworkingUtils()->GetLocalTimestamp();
+		for (int i = 0; i < JITTER_HEADER_SIZE; i++) {
+			w[STREAM_HEADER_SIZE + i] = (sent >> (8 * i)) & 0xFF;
+		}
+	}
+}
+
+// Group members, or for no group every connection matching a broadcast target_peer:
+// 0 for all of them, -peer_id for all but that peer.
+void SteamMultiplayerPeer::_collect_targets(int32_t p_peer, int32_t p_group, LocalVector<Ref<SteamConnection>> &r_targets) const {
+	if (p_group != TARGET_GROUP_NONE) {
+		HashMap<int32_t, HashSet<int32_t>>::ConstIterator G = peer_groups.find(p_group);
+		if (!G) {
+			return;
+		}
+		for (const int32_t &member : G->value) {
+			HashMap<int32_t, uint32_t>::ConstIterator E = slot_by_peer_id.find(member);
+			if (E) {
+				r_targets.push_back(connection_slots[E->value].connection);
+			}
+		}
+		return;
+	}
+	int32_t excluded_peer = -p_peer;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && (excluded_peer == 0 || connection->peer_id != excluded_peer)) {
+			r_targets.push_back(connection);
+		}
+	}
+}
+
+// Relayed packets belong to another peer, so this peer's send settings don't apply to them.
+Ref<SteamPacketPeer> SteamMultiplayerPeer::_make_packet(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, bool p_relayed) const {
+	Ref<SteamPacketPeer> packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer(p_buffer, p_buffer_size, p_flags)));
+	if (p_relayed) {
+		return packet;
+	}
+	packet->priority = send_priority;
+	packet->key = send_key;
+	if (collect_histograms) {
+		packet->channel = _get_stream_header_size(p_flags) > 0 ? send_stream : 0;
+		packet->queued_at = SteamNetworkingUtils()->GetLocalTimestamp();
+	}
+	if (send_ttl > 0) {
+		packet->deadline = Time::get_singleton()->get_ticks_usec() + (uint64_t)send_ttl * 1000;
+	}
+	return packet;
+}
+
+// Sends one payload to several connections with a single SendMessages call. Connections
+// that already have queued packets, or a send budget, go through their scheduler instead.
+Error SteamMultiplayerPeer::_multicast(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, const LocalVector<Ref<SteamConnection>> &p_targets, bool p_relayed) {
+	Error returnValue = OK;
+	LocalVector<SteamNetworkingMessage_t *> messages;
+	LocalVector<Ref<SteamConnection>> batched;
+	messages.reserve(p_targets.size());
+	batched.reserve(p_targets.size());
+
+	uint16_t channel = _get_stream_header_size(p_flags) > 0 ? send_stream : 0;
+	for (uint32_t i = 0; i < p_targets.size(); i++) {
+		const Ref<SteamConnection> &target = p_targets[i];
+		if (collect_histograms && !p_relayed) {
+			_get_channel_histograms(target->peer_id, channel).sent_size.record(p_buffer_size);
+		}
+		if (target->pending_retry_packets.size() > 0 || target->is_parked() || target->max_pending_bytes > 0) {
+			Error errorCode = target->send(_make_packet(p_buffer, p_buffer_size, p_flags, p_relayed));
 			if (errorCode != OK) {
 				returnValue = errorCode;
 			}
+			continue;
 		}
+		SteamNetworkingMessage_t *msg = SteamNetworkingUtils()->AllocateMessage(p_buffer_size);
+		memcpy(msg->m_pData, p_buffer, p_buffer_size);
+		msg->m_conn = target->steam_connection;
+		msg->m_nFlags = p_flags;
+		messages.push_back(msg);
+		batched.push_back(target);
+	}
+
+	if (messages.size() == 0) {
 		return returnValue;
-	} else {
-		Ref<SteamPacketPeer> packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer(p_buffer, p_buffer_size, transferMode)));
-		return get_connection_by_peer(target_peer)->send(packet);
 	}
+
+	LocalVector<int64> results;
+	results.resize(messages.size());
+	int64_t started = collect_histograms ? SteamNetworkingUtils()->GetLocalTimestamp() : 0;
+	// SendMessages takes ownership of every message, whether or not it succeeds.
+	SteamNetworkingSockets()->SendMessages(messages.size(), messages.ptr(), results.ptr());
+	if (collect_histograms && !p_relayed) {
+		int64_t elapsed = SteamNetworkingUtils()->GetLocalTimestamp() - started;
+		for (uint32_t i = 0; i < batched.size(); i++) {
+			if (results[i] >= 0) {
+				batched[i]->send_latency[channel].record(elapsed);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < results.size(); i++) {
+		if (results[i] >= 0) {
+			continue;
+		}
+		if (p_flags & k_nSteamNetworkingSend_Reliable) {
+			// Hand the payload to the connection queue so it is retried on later sends.
+			batched[i]->enqueue(_make_packet(p_buffer, p_buffer_size, p_flags, p_relayed));
+		} else {
+			WARN_PRINT(vformat("Multicast send error (Unreliable, won't retry): %d", -results[i]));
+		}
+	}
+	return returnValue;
 }
 
 int32_t SteamMultiplayerPeer::_get_available_packet_count() const {
@@ -60,7 +255,11 @@ int32_t SteamMultiplayerPeer::_get_available_packet_count() const {
 }
 
 int32_t SteamMultiplayerPeer::_get_max_packet_size() const {
-	return k_cbMaxSteamNetworkingSocketsMessageSizeSend;
+	int32_t size = k_cbMaxSteamNetworkingSocketsMessageSizeSend - (native_relay ? RELAY_HEADER_SIZE : 0) - (split_unreliable ? 1 : 0);
+	if (stream_coalescing) {
+		return size - STREAM_HEADER_SIZE - (jitter_stream != 0 ? JITTER_HEADER_SIZE : 0);
+	}
+	return size;
 }
 
 int32_t SteamMultiplayerPeer::_get_packet_channel() const {
@@ -95,41 +294,106 @@ MultiplayerPeer::TransferMode SteamMultiplayerPeer::_get_transfer_mode() const {
 
 void SteamMultiplayerPeer::_set_target_peer(int32_t p_peer) {
 	target_peer = p_peer;
+	target_group = TARGET_GROUP_NONE;
 }
 
 int32_t SteamMultiplayerPeer::_get_packet_peer() const {
 	ERR_FAIL_COND_V_MSG(!_is_active(), 1, "The multiplayer instance isn't currently active.");
 	ERR_FAIL_COND_V_MSG(incoming_packets.size() == 0, 1, "No packets to receive.");
 
-	int32_t peer_id = connections_by_steamId64[incoming_packets.front()->get()->sender]->peer_id;
-	return peer_id;
+	return incoming_packets.front()->get()->peer_id;
 }
 
 bool SteamMultiplayerPeer::_is_server() const {
 	return unique_id == 1;
 }
 
-#define MAX_MESSAGE_COUNT 255
 void SteamMultiplayerPeer::_poll() {
 	ERR_FAIL_COND_MSG(!_is_active(), "The multiplayer instance isn't currently active.");
+	STEAM_TRACE_ZONE("SteamMultiplayerPeer::_poll");
 
-	SteamNetworkingMessage_t *messages[MAX_MESSAGE_COUNT];
-
-	for (HashMap<uint64_t, Ref<SteamConnection>>::ConstIterator E = connections_by_steamId64.begin(); E; ++E) {
-		int64_t key = E->key;
-		Ref<SteamConnection> value = E->value;
-		int count = SteamNetworkingSockets()->ReceiveMessagesOnConnection(value->steam_connection, messages, MAX_MESSAGE_COUNT);
-		if (count > 0) {
-			for (int i = 0; i < count; i++) {
-				SteamNetworkingMessage_t *msg = messages[i];
-				if (get_peer_id_from_steam64(msg->m_identityPeer.GetSteamID64()) != -1) {
-					_process_message(msg);
-				} else {
-					_process_ping(msg);
+	uint64_t allocations = SteamMemoryStats::packet_allocations.load(std::memory_order_relaxed);
+	allocations_last_poll = allocations - allocations_at_poll;
+	allocations_at_poll = allocations;
+
+	// Connection state changes first, so a peer that connects this tick gets its messages too.
+	SteamNetworkingHub::get_singleton()->poll();
+	if (status_events.size() > 0) {
+		_process_status_events();
+		if (!_is_active()) {
+			return;
+		}
+	}
+	if (pending_accepts.size() > 0) {
+		_drain_pending_accepts();
+	}
+
+	// Closing during the loop releases incoming_messages, so process a detached batch.
+	SWAP(processing_messages, incoming_messages);
+	int count = processing_messages.size();
+	STEAM_TRACE_VALUE(count);
+	if (collect_histograms) {
+		poll_drain.record(count);
+	}
+	for (int i = 0; i < count; i++) {
+		SteamNetworkingMessage_t *msg = processing_messages[i];
+		// Signals emitted while processing may close this peer, drop the rest of the batch.
+		if (_is_active()) {
+			Ref<SteamConnection> sender = _get_connection_by_slot(_find_message_slot(msg));
+			int32_t assigned_peer_id;
+			if (awaiting_peer_id) {
+				if (!_accept_assigned_peer_id(msg)) {
+					WARN_PRINT(String("Received message before the host assigned a peer id, dropping."));
 				}
-				msg->Release();
+			} else if (awaiting_session.size() > 0 && awaiting_session.has(msg->m_conn)) {
+				if (!_accept_session_token(msg)) {
+					WARN_PRINT(String("Received message before the client's session token, dropping."));
+				}
+			} else if (ip_transport && active_mode == MODE_CLIENT && _read_assigned_peer_id(msg, &assigned_peer_id)) {
+				// Never application data. Sent again when the host registered a redial as a new join.
+				if (assigned_peer_id != unique_id) {
+					WARN_PRINT(vformat("The host reassigned this peer from id %d to %d, keeping %d.", unique_id, assigned_peer_id, unique_id));
+				}
+			} else if (sender.is_null() || sender->peer_id == -1) {
+				WARN_PRINT(String("Received message from unknown connection, dropping."));
+			} else if (native_relay && active_mode == MODE_SERVER) {
+				RelayResult relay = _relay_message(msg, sender);
+				if (relay == RELAY_CONSUMED) {
+					continue;
+				}
+				if (relay == RELAY_DELIVER) {
+					_process_message(msg, sender);
+				}
+			} else {
+				_process_message(msg, sender);
 			}
 		}
+		msg->Release();
+	}
+	processing_messages.clear();
+
+	// Release packets the scheduler held back on earlier polls.
+	for (uint32_t i = 0; i < connection_slots.size() && _is_active(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && connection->pending_retry_packets.size() > 0) {
+			connection->resend_pending();
+		}
+	}
+
+	if (parked_slots.size() > 0 && _is_active()) {
+		_update_parked_connections();
+	}
+
+	if (split_messages.size() > 0) {
+		_expire_split_messages();
+	}
+	if (jitter_buffers.size() > 0) {
+		_release_jitter_buffers();
+	}
+
+	poll_count++;
+	if (adaptive_rate && _is_active() && poll_count % adaptive_rate_interval == 0) {
+		_update_adaptive_rates();
 	}
 }
 
@@ -141,42 +405,58 @@ void SteamMultiplayerPeer::_close() {
 		return;
 	}
 
-	for (HashMap<uint64_t, Ref<SteamConnection>>::ConstIterator E = connections_by_steamId64.begin(); E; ++E) {
-		const Ref<SteamConnection> connection = E->value;
-		// TODO On Enet disconnect all peers with
-		// peer_disconnect_now(0);
-		connection->close();
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && !connection->is_parked()) {
+			// TODO On Enet disconnect all peers with
+			// peer_disconnect_now(0);
+			connection->close();
+		}
 	}
 
-	if (_is_server()) {
+	if (_is_server() || (mesh && listen_socket != k_HSteamListenSocket_Invalid)) {
 		close_listen_socket();
 	}
+	listen_socket = k_HSteamListenSocket_Invalid;
 
-	peerId_to_steamId.clear();
-	connections_by_steamId64.clear();
+	_clear_connections();
 	active_mode = MODE_NONE;
 	unique_id = 0;
+	ip_transport = false;
+	mesh = false;
+	mesh_peers.clear();
+	awaiting_peer_id = false;
 	connection_status = CONNECTION_DISCONNECTED;
 }
 
 void SteamMultiplayerPeer::_disconnect_peer(int32_t p_peer, bool p_force) {
 	ERR_FAIL_COND_MSG(!_is_active(), "The multiplayer instance isn't currently active.");
-	ERR_FAIL_COND_MSG(!peerId_to_steamId.has(p_peer), "'PeerConnection' not registered for steam_id. Try p_force true if need clear all multiplayer data.");
-	Ref<SteamConnection> connection = get_connection_by_peer(p_peer);
+	ERR_FAIL_COND_MSG(!slot_by_peer_id.has(p_peer), "'PeerConnection' not registered for steam_id. Try p_force true if need clear all multiplayer data.");
+	uint32_t slot = slot_by_peer_id[p_peer];
+	Ref<SteamConnection> connection = connection_slots[slot].connection;
+	bool announce = mesh && _is_server();
+	if (connection->is_parked()) {
+		parked_slots.erase(connection->steam_id);
+		_remove_connection(slot);
+		if (announce) {
+			_mesh_peer_left(connection->steam_id);
+		}
+		return;
+	}
 	bool result = connection->close();
 	if (!result) {
 		return;
 	}
 
 	connection->flush();
-	connections_by_steamId64.erase(connection->steam_id);
-	peerId_to_steamId.erase(p_peer);
-	if (active_mode == MODE_CLIENT || active_mode == MODE_SERVER) {
-		get_connection_by_peer(0)->flush();
-	} else {
-		// TODO for MESH type
-		// ERR_FAIL_COND(!hosts.has(p_peer));
-		// hosts[p_peer]->flush();
+	_remove_connection(slot);
+	if (announce) {
+		_mesh_peer_left(connection->steam_id);
+	}
+	// Mesh links are plain connections too, a client dropping one falls back to the host relay.
+	Ref<SteamConnection> host = get_connection_by_peer(0);
+	if (host.is_valid()) {
+		host->flush();
 	}
 	if (p_force) {
 		//peers.erase(p_peer);
@@ -184,7 +464,7 @@ void SteamMultiplayerPeer::_disconnect_peer(int32_t p_peer, bool p_force) {
 		// 	hosts.erase(p_peer);
 		// }
 		if (active_mode == MODE_CLIENT) {
-			connections_by_steamId64.clear(); // Avoid flushing again.
+			_clear_connections(); // Avoid flushing again.
 			close();
 		}
 	}
@@ -195,6 +475,14 @@ int32_t SteamMultiplayerPeer::_get_unique_id() const {
 	return unique_id;
 }
 
+void SteamMultiplayerPeer::_set_refuse_new_connections(bool p_enable) {
+	refuse_new_connections = p_enable;
+}
+
+bool SteamMultiplayerPeer::_is_refusing_new_connections() const {
+	return refuse_new_connections;
+}
+
 bool SteamMultiplayerPeer::_is_server_relay_supported() const {
 	return active_mode == MODE_SERVER || active_mode == MODE_CLIENT;
 }
@@ -208,6 +496,7 @@ bool SteamMultiplayerPeer::close_listen_socket() {
 		WARN_PRINT(String("SteamNetworkingSockets is null!"));
 		return false;
 	}
+	SteamNetworkingHub::get_singleton()->release_listen_socket(listen_socket);
 	if (!SteamNetworkingSockets()->CloseListenSocket(listen_socket)) {
 		WARN_PRINT(String("Fail to close listen socket "));
 		return false;
@@ -217,20 +506,20 @@ bool SteamMultiplayerPeer::close_listen_socket() {
 
 Error SteamMultiplayerPeer::create_host(int n_local_virtual_port) {
 	ERR_FAIL_COND_V_MSG(_is_active(), ERR_ALREADY_IN_USE, "The multiplayer instance is already active.");
-	if (SteamNetworkingSockets() == NULL) {
+#ifdef STEAM_PEER_GNS
+	ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "P2P hosting needs the Steamworks backend, use create_host_ip.");
+#endif
+	if (!SteamNetworkingHub::get_singleton()->init_sockets()) {
 		return Error::ERR_UNAVAILABLE;
 	}
-	SteamNetworkingUtils()->InitRelayNetworkAccess();
-
-	const SteamNetworkingConfigValue_t *these_options = configs->get_convert_options();
+	_ensure_relay_network_access();
 
-	listen_socket = SteamNetworkingSockets()->CreateListenSocketP2P(n_local_virtual_port, configs->size(), these_options);
-
-	delete[] these_options;
+	listen_socket = SteamNetworkingSockets()->CreateListenSocketP2P(n_local_virtual_port, _get_connection_option_count(), _get_connection_options());
 
 	if (listen_socket == k_HSteamListenSocket_Invalid) {
 		return Error::ERR_CANT_CREATE;
 	}
+	SteamNetworkingHub::get_singleton()->claim_listen_socket(listen_socket, this);
 	unique_id = 1;
 	active_mode = MODE_SERVER;
 	connection_status = ConnectionStatus::CONNECTION_CONNECTED;
@@ -239,30 +528,202 @@ Error SteamMultiplayerPeer::create_host(int n_local_virtual_port) {
 
 Error SteamMultiplayerPeer::create_client(uint64_t identity_remote, int n_remote_virtual_port) {
 	ERR_FAIL_COND_V_MSG(_is_active(), ERR_ALREADY_IN_USE, "The multiplayer instance is already active.");
-	if (SteamNetworkingSockets() == NULL) {
+#ifdef STEAM_PEER_GNS
+	ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "P2P connections need the Steamworks backend, use create_client_ip.");
+#endif
+	if (!SteamNetworkingHub::get_singleton()->init_sockets()) {
 		return Error::ERR_UNAVAILABLE;
 	}
-	unique_id = generate_unique_id();
-	SteamNetworkingUtils()->InitRelayNetworkAccess();
+	unique_id = _derive_peer_id(_local_steam_id());
+	_ensure_relay_network_access();
 	SteamNetworkingIdentity p_remote_id;
 	p_remote_id.SetSteamID64(identity_remote);
 
-	SteamNetworkingConfigValue_t *these_options = configs->get_convert_options();
-
-	connection = SteamNetworkingSockets()->ConnectP2P(p_remote_id, n_remote_virtual_port, configs->size(), these_options);
-
-	delete[] these_options;
+	connection = SteamNetworkingSockets()->ConnectP2P(p_remote_id, n_remote_virtual_port, _get_connection_option_count(), _get_connection_options());
+	remote_steam_id = identity_remote;
+	remote_virtual_port = n_remote_virtual_port;
 
 	if (connection == k_HSteamNetConnection_Invalid) {
 		unique_id = 0;
 		return Error::ERR_CANT_CONNECT;
 	}
+	SteamNetworkingHub::get_singleton()->claim_connection(connection, this);
+
+	active_mode = MODE_CLIENT;
+	connection_status = ConnectionStatus::CONNECTION_CONNECTING;
+	return Error::OK;
+}
+
+// Listens on address:port, an empty address listens on every local interface.
+Error SteamMultiplayerPeer::create_host_ip(const String &address, int port) {
+	ERR_FAIL_COND_V_MSG(_is_active(), ERR_ALREADY_IN_USE, "The multiplayer instance is already active.");
+	ERR_FAIL_COND_V_MSG(port < 0 || port > 65535, ERR_INVALID_PARAMETER, "Invalid port.");
+	if (!SteamNetworkingHub::get_singleton()->init_sockets()) {
+		return Error::ERR_UNAVAILABLE;
+	}
+	SteamNetworkingIPAddr local_address;
+	local_address.Clear();
+	if (!address.is_empty()) {
+		ERR_FAIL_COND_V_MSG(!local_address.ParseString(address.utf8().get_data()), ERR_INVALID_PARAMETER, vformat("Invalid IP address: %s", address));
+	}
+	local_address.m_port = port;
 
+	listen_socket = SteamNetworkingSockets()->CreateListenSocketIP(local_address, _get_connection_option_count(), _get_connection_options());
+	if (listen_socket == k_HSteamListenSocket_Invalid) {
+		return Error::ERR_CANT_CREATE;
+	}
+	SteamNetworkingHub::get_singleton()->claim_listen_socket(listen_socket, this);
+	unique_id = 1;
+	ip_transport = true;
+	active_mode = MODE_SERVER;
+	connection_status = ConnectionStatus::CONNECTION_CONNECTED;
+	return Error::OK;
+}
+
+Error SteamMultiplayerPeer::create_client_ip(const String &address, int port) {
+	ERR_FAIL_COND_V_MSG(_is_active(), ERR_ALREADY_IN_USE, "The multiplayer instance is already active.");
+	ERR_FAIL_COND_V_MSG(port <= 0 || port > 65535, ERR_INVALID_PARAMETER, "Invalid port.");
+	if (!SteamNetworkingHub::get_singleton()->init_sockets()) {
+		return Error::ERR_UNAVAILABLE;
+	}
+	SteamNetworkingIPAddr remote_address;
+	remote_address.Clear();
+	ERR_FAIL_COND_V_MSG(!remote_address.ParseString(address.utf8().get_data()), ERR_INVALID_PARAMETER, vformat("Invalid IP address: %s", address));
+	remote_address.m_port = port;
+
+	connection = SteamNetworkingSockets()->ConnectByIPAddress(remote_address, _get_connection_option_count(), _get_connection_options());
+	if (connection == k_HSteamNetConnection_Invalid) {
+		return Error::ERR_CANT_CONNECT;
+	}
+	SteamNetworkingHub::get_singleton()->claim_connection(connection, this);
+	remote_ip_address = remote_address;
+	session_token = ((uint64_t)UtilityFunctions::randi() << 32) | (uint64_t)UtilityFunctions::randi();
+	unique_id = 0; // assigned by the host
+	ip_transport = true;
 	active_mode = MODE_CLIENT;
 	connection_status = ConnectionStatus::CONNECTION_CONNECTING;
 	return Error::OK;
 }
 
+#define ASSIGNED_PEER_ID_MAGIC 0x49504D53 // "SMPI"
+#define ASSIGNED_PEER_ID_SIZE 8
+
+void SteamMultiplayerPeer::_send_assigned_peer_id(HSteamNetConnection p_connection, int32_t p_peer_id) {
+	uint8_t payload[ASSIGNED_PEER_ID_SIZE];
+	for (int i = 0; i < 4; i++) {
+		payload[i] = (ASSIGNED_PEER_ID_MAGIC >> (8 * i)) & 0xFF;
+		payload[4 + i] = ((uint32_t)p_peer_id >> (8 * i)) & 0xFF;
+	}
+	EResult result = SteamNetworkingSockets()->SendMessageToConnection(p_connection, payload, ASSIGNED_PEER_ID_SIZE, k_nSteamNetworkingSend_Reliable, nullptr);
+	ERR_FAIL_COND_MSG(result != k_EResultOK, vformat("Failed to send the assigned peer id: %d", result));
+}
+
+bool SteamMultiplayerPeer::_read_assigned_peer_id(const SteamNetworkingMessage_t *p_msg, int32_t *r_peer_id) {
+	if (!(p_msg->m_nFlags & k_nSteamNetworkingSend_Reliable) || p_msg->GetSize() != ASSIGNED_PEER_ID_SIZE) {
+		return false;
+	}
+	const uint8_t *r = (const uint8_t *)p_msg->GetData();
+	uint32_t magic = r[0] | (r[1] << 8) | (r[2] << 16) | ((uint32_t)r[3] << 24);
+	*r_peer_id = (int32_t)(r[4] | (r[5] << 8) | (r[6] << 16) | ((uint32_t)r[7] << 24));
+	return magic == ASSIGNED_PEER_ID_MAGIC && *r_peer_id >= 2;
+}
+
+// Reliable messages arrive in order, so the host's peer id message is the first reliable
+// message on the connection. Unreliable ones sent before it are dropped.
+bool SteamMultiplayerPeer::_accept_assigned_peer_id(const SteamNetworkingMessage_t *p_msg) {
+	int32_t peer_id;
+	if (!_read_assigned_peer_id(p_msg, &peer_id)) {
+		return false;
+	}
+	unique_id = peer_id;
+	awaiting_peer_id = false;
+	connection_status = ConnectionStatus::CONNECTION_CONNECTED;
+	emit_signal("peer_connected", 1);
+	return true;
+}
+
+#define SESSION_TOKEN_MAGIC 0x53504D53 // "SMPS"
+#define SESSION_TOKEN_SIZE 12
+
+void SteamMultiplayerPeer::_send_session_token(HSteamNetConnection p_connection) {
+	uint8_t payload[SESSION_TOKEN_SIZE];
+	for (int i = 0; i < 4; i++) {
+		payload[i] = (SESSION_TOKEN_MAGIC >> (8 * i)) & 0xFF;
+	}
+	for (int i = 0; i < 8; i++) {
+		payload[4 + i] = (session_token >> (8 * i)) & 0xFF;
+	}
+	EResult result = SteamNetworkingSockets()->SendMessageToConnection(p_connection, payload, SESSION_TOKEN_SIZE, k_nSteamNetworkingSend_Reliable, nullptr);
+	ERR_FAIL_COND_MSG(result != k_EResultOK, vformat("Failed to send the session token: %d", result));
+}
+
+// Host side of _send_session_token. Unreliable messages that overtake the token are dropped.
+// Admission is checked again, since a client resuming into a parked slot could only be told
+// apart once its token arrived.
+bool SteamMultiplayerPeer::_accept_session_token(const SteamNetworkingMessage_t *p_msg) {
+	if (!(p_msg->m_nFlags & k_nSteamNetworkingSend_Reliable) || p_msg->GetSize() != SESSION_TOKEN_SIZE) {
+		return false;
+	}
+	const uint8_t *r = (const uint8_t *)p_msg->GetData();
+	uint32_t magic = r[0] | (r[1] << 8) | (r[2] << 16) | ((uint32_t)r[3] << 24);
+	uint64_t token = 0;
+	for (int i = 0; i < 8; i++) {
+		token |= (uint64_t)r[4 + i] << (8 * i);
+	}
+	if (magic != SESSION_TOKEN_MAGIC) {
+		return false;
+	}
+	HSteamNetConnection handle = p_msg->m_conn;
+	uint64_t key = awaiting_session[handle];
+	awaiting_session.erase(handle);
+	if (_is_address_key(key)) {
+		key = (token & 0x00FFFFFFFFFFFFFF) | 0xFE00000000000000;
+	}
+	accepting.erase(handle);
+	int reason = _get_admission_reject(key);
+	if (reason != 0) {
+		rejected_connections++;
+		_close_connection_handle(handle, reason, "Rejected by admission control");
+		return true;
+	}
+	_on_connection_established(key, handle);
+	return true;
+}
+
+// Steam IDs where the remote has one, otherwise a hash of the identity string (an IP address
+// for unauthenticated IP connections). The top byte is set to an invalid Steam universe so
+// the two ranges never collide.
+uint64_t SteamMultiplayerPeer::_identity_key(const SteamNetworkingIdentity &p_identity) {
+	uint64_t steam_id = p_identity.GetSteamID64();
+	if (steam_id != 0) {
+		return steam_id;
+	}
+	char identity[SteamNetworkingIdentity::k_cchMaxString];
+	p_identity.ToString(identity, sizeof(identity));
+	int length = strlen(identity);
+	uint64_t hash = ((uint64_t)hash_murmur3_buffer(identity, length, 0x7F07C65) << 32) | hash_murmur3_buffer(identity, length, 0x2545F491);
+	return (hash & 0x00FFFFFFFFFFFFFF) | 0xFF00000000000000;
+}
+
+// Keyed by the remote's ip:port, which is not stable across a redial.
+bool SteamMultiplayerPeer::_is_address_key(uint64_t p_key) {
+	return (p_key >> 56) == 0xFF;
+}
+
+// Keyed by an IP client's session token, only ever reused by the same client redialing.
+bool SteamMultiplayerPeer::_is_session_key(uint64_t p_key) {
+	return (p_key >> 56) == 0xFE;
+}
+
+// 0 without a Steam user, as on IP-only dedicated servers and GameNetworkingSockets builds.
+uint64_t SteamMultiplayerPeer::_local_steam_id() const {
+#ifdef STEAM_PEER_GNS
+	return 0;
+#else
+	return SteamUser() ? SteamUser()->GetSteamID().ConvertToUint64() : 0;
+#endif
+}
+
 bool SteamMultiplayerPeer::get_identity(SteamNetworkingIdentity *p_identity) {
 	return SteamNetworkingSockets()->GetIdentity(p_identity);
 }
@@ -270,6 +731,14 @@ bool SteamMultiplayerPeer::get_identity(SteamNetworkingIdentity *p_identity) {
 void SteamMultiplayerPeer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("create_host", "n_local_virtual_port"), &SteamMultiplayerPeer::create_host, DEFVAL(nullptr));
 	ClassDB::bind_method(D_METHOD("create_client", "identity_remote", "n_local_virtual_port"), &SteamMultiplayerPeer::create_client, DEFVAL(nullptr));
+	ClassDB::bind_method(D_METHOD("set_native_relay", "native_relay"), &SteamMultiplayerPeer::set_native_relay);
+	ClassDB::bind_method(D_METHOD("get_native_relay"), &SteamMultiplayerPeer::get_native_relay);
+	ClassDB::bind_method(D_METHOD("get_relayed_packet_count"), &SteamMultiplayerPeer::get_relayed_packet_count);
+	ClassDB::bind_method(D_METHOD("create_mesh", "host_steam_id", "n_virtual_port"), &SteamMultiplayerPeer::create_mesh);
+	ClassDB::bind_method(D_METHOD("is_mesh"), &SteamMultiplayerPeer::is_mesh);
+	ClassDB::bind_method(D_METHOD("has_mesh_link", "peer_id"), &SteamMultiplayerPeer::has_mesh_link);
+	ClassDB::bind_method(D_METHOD("create_host_ip", "address", "port"), &SteamMultiplayerPeer::create_host_ip);
+	ClassDB::bind_method(D_METHOD("create_client_ip", "address", "port"), &SteamMultiplayerPeer::create_client_ip);
 	ClassDB::bind_method(D_METHOD("set_listen_socket", "listen_socket"), &SteamMultiplayerPeer::set_listen_socket);
 	ClassDB::bind_method(D_METHOD("get_listen_socket"), &SteamMultiplayerPeer::get_listen_socket);
 	ClassDB::bind_method(D_METHOD("get_steam64_from_peer_id", "peer_id"), &SteamMultiplayerPeer::get_steam64_from_peer_id);
@@ -285,20 +754,130 @@ void SteamMultiplayerPeer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_config", "config", "value"), &SteamMultiplayerPeer::set_config);
 	ClassDB::bind_method(D_METHOD("clear_config", "config"), &SteamMultiplayerPeer::clear_config);
 	ClassDB::bind_method(D_METHOD("clear_all_configs"), &SteamMultiplayerPeer::clear_all_configs);
+	ClassDB::bind_method(D_METHOD("apply_configs_to_peer", "peer_id"), &SteamMultiplayerPeer::apply_configs_to_peer);
+	ClassDB::bind_method(D_METHOD("apply_configs_to_all_peers"), &SteamMultiplayerPeer::apply_configs_to_all_peers);
+	ClassDB::bind_method(D_METHOD("set_adaptive_rate", "adaptive_rate"), &SteamMultiplayerPeer::set_adaptive_rate);
+	ClassDB::bind_method(D_METHOD("get_adaptive_rate"), &SteamMultiplayerPeer::get_adaptive_rate);
+	ClassDB::bind_method(D_METHOD("set_adaptive_rate_interval", "polls"), &SteamMultiplayerPeer::set_adaptive_rate_interval);
+	ClassDB::bind_method(D_METHOD("get_adaptive_rate_interval"), &SteamMultiplayerPeer::get_adaptive_rate_interval);
+	ClassDB::bind_method(D_METHOD("set_adaptive_send_rate_min", "bytes_per_second"), &SteamMultiplayerPeer::set_adaptive_send_rate_min);
+	ClassDB::bind_method(D_METHOD("get_adaptive_send_rate_min"), &SteamMultiplayerPeer::get_adaptive_send_rate_min);
+	ClassDB::bind_method(D_METHOD("set_adaptive_send_rate_max", "bytes_per_second"), &SteamMultiplayerPeer::set_adaptive_send_rate_max);
+	ClassDB::bind_method(D_METHOD("get_adaptive_send_rate_max"), &SteamMultiplayerPeer::get_adaptive_send_rate_max);
+	ClassDB::bind_method(D_METHOD("set_adaptive_target_queue_time", "msec"), &SteamMultiplayerPeer::set_adaptive_target_queue_time);
+	ClassDB::bind_method(D_METHOD("get_adaptive_target_queue_time"), &SteamMultiplayerPeer::get_adaptive_target_queue_time);
+	ClassDB::bind_method(D_METHOD("get_peer_update_rate", "peer_id"), &SteamMultiplayerPeer::get_peer_update_rate);
+	ClassDB::bind_method(D_METHOD("get_peer_send_rate", "peer_id"), &SteamMultiplayerPeer::get_peer_send_rate);
+	ClassDB::bind_method(D_METHOD("set_send_priority", "priority"), &SteamMultiplayerPeer::set_send_priority);
+	ClassDB::bind_method(D_METHOD("get_send_priority"), &SteamMultiplayerPeer::get_send_priority);
+	ClassDB::bind_method(D_METHOD("set_send_ttl", "msec"), &SteamMultiplayerPeer::set_send_ttl);
+	ClassDB::bind_method(D_METHOD("get_send_ttl"), &SteamMultiplayerPeer::get_send_ttl);
+	ClassDB::bind_method(D_METHOD("set_send_key", "key"), &SteamMultiplayerPeer::set_send_key);
+	ClassDB::bind_method(D_METHOD("get_send_key"), &SteamMultiplayerPeer::get_send_key);
+	ClassDB::bind_method(D_METHOD("set_stream_coalescing", "stream_coalescing"), &SteamMultiplayerPeer::set_stream_coalescing);
+	ClassDB::bind_method(D_METHOD("get_stream_coalescing"), &SteamMultiplayerPeer::get_stream_coalescing);
+	ClassDB::bind_method(D_METHOD("set_send_stream", "stream"), &SteamMultiplayerPeer::set_send_stream);
+	ClassDB::bind_method(D_METHOD("get_send_stream"), &SteamMultiplayerPeer::get_send_stream);
+	ClassDB::bind_method(D_METHOD("get_coalesced_packet_count"), &SteamMultiplayerPeer::get_coalesced_packet_count);
+	ClassDB::bind_method(D_METHOD("set_jitter_stream", "stream"), &SteamMultiplayerPeer::set_jitter_stream);
+	ClassDB::bind_method(D_METHOD("get_jitter_stream"), &SteamMultiplayerPeer::get_jitter_stream);
+	ClassDB::bind_method(D_METHOD("set_jitter_min_delay", "milliseconds"), &SteamMultiplayerPeer::set_jitter_min_delay);
+	ClassDB::bind_method(D_METHOD("get_jitter_min_delay"), &SteamMultiplayerPeer::get_jitter_min_delay);
+	ClassDB::bind_method(D_METHOD("set_jitter_max_delay", "milliseconds"), &SteamMultiplayerPeer::set_jitter_max_delay);
+	ClassDB::bind_method(D_METHOD("get_jitter_max_delay"), &SteamMultiplayerPeer::get_jitter_max_delay);
+	ClassDB::bind_method(D_METHOD("get_peer_jitter", "peer_id"), &SteamMultiplayerPeer::get_peer_jitter);
+	ClassDB::bind_method(D_METHOD("get_peer_playout_delay", "peer_id"), &SteamMultiplayerPeer::get_peer_playout_delay);
+	ClassDB::bind_method(D_METHOD("get_late_packet_count"), &SteamMultiplayerPeer::get_late_packet_count);
+	ClassDB::bind_method(D_METHOD("set_split_unreliable", "split_unreliable"), &SteamMultiplayerPeer::set_split_unreliable);
+	ClassDB::bind_method(D_METHOD("get_split_unreliable"), &SteamMultiplayerPeer::get_split_unreliable);
+	ClassDB::bind_method(D_METHOD("set_split_timeout", "milliseconds"), &SteamMultiplayerPeer::set_split_timeout);
+	ClassDB::bind_method(D_METHOD("get_split_timeout"), &SteamMultiplayerPeer::get_split_timeout);
+	ClassDB::bind_method(D_METHOD("set_deliver_partial_messages", "deliver_partial_messages"), &SteamMultiplayerPeer::set_deliver_partial_messages);
+	ClassDB::bind_method(D_METHOD("get_deliver_partial_messages"), &SteamMultiplayerPeer::get_deliver_partial_messages);
+	ClassDB::bind_method(D_METHOD("is_last_packet_partial"), &SteamMultiplayerPeer::is_last_packet_partial);
+	ClassDB::bind_method(D_METHOD("get_incomplete_message_count"), &SteamMultiplayerPeer::get_incomplete_message_count);
+	ClassDB::bind_method(D_METHOD("get_memory_stats"), &SteamMultiplayerPeer::get_memory_stats);
+	ClassDB::bind_method(D_METHOD("get_memory_stat", "name"), &SteamMultiplayerPeer::get_memory_stat);
+	ClassDB::bind_method(D_METHOD("add_performance_monitors"), &SteamMultiplayerPeer::add_performance_monitors);
+	ClassDB::bind_method(D_METHOD("remove_performance_monitors"), &SteamMultiplayerPeer::remove_performance_monitors);
+	ClassDB::bind_method(D_METHOD("set_collect_histograms", "collect_histograms"), &SteamMultiplayerPeer::set_collect_histograms);
+	ClassDB::bind_method(D_METHOD("get_collect_histograms"), &SteamMultiplayerPeer::get_collect_histograms);
+	ClassDB::bind_method(D_METHOD("get_histograms"), &SteamMultiplayerPeer::get_histograms);
+	ClassDB::bind_method(D_METHOD("reset_histograms"), &SteamMultiplayerPeer::reset_histograms);
+	ClassDB::bind_method(D_METHOD("dump_network_trace", "path"), &SteamMultiplayerPeer::dump_network_trace);
+	ClassDB::bind_method(D_METHOD("get_packets_batch", "max"), &SteamMultiplayerPeer::get_packets_batch);
+	ClassDB::bind_method(D_METHOD("put_packets_batch", "payloads", "records"), &SteamMultiplayerPeer::put_packets_batch);
+	ClassDB::bind_method(D_METHOD("set_send_queue_budget", "bytes"), &SteamMultiplayerPeer::set_send_queue_budget);
+	ClassDB::bind_method(D_METHOD("get_send_queue_budget"), &SteamMultiplayerPeer::get_send_queue_budget);
+	ClassDB::bind_method(D_METHOD("set_reconnect_grace_time", "msec"), &SteamMultiplayerPeer::set_reconnect_grace_time);
+	ClassDB::bind_method(D_METHOD("get_reconnect_grace_time"), &SteamMultiplayerPeer::get_reconnect_grace_time);
+	ClassDB::bind_method(D_METHOD("set_max_clients", "max_clients"), &SteamMultiplayerPeer::set_max_clients);
+	ClassDB::bind_method(D_METHOD("get_max_clients"), &SteamMultiplayerPeer::get_max_clients);
+	ClassDB::bind_method(D_METHOD("set_accept_rate", "connections_per_second"), &SteamMultiplayerPeer::set_accept_rate);
+	ClassDB::bind_method(D_METHOD("get_accept_rate"), &SteamMultiplayerPeer::get_accept_rate);
+	ClassDB::bind_method(D_METHOD("set_accept_burst", "accept_burst"), &SteamMultiplayerPeer::set_accept_burst);
+	ClassDB::bind_method(D_METHOD("get_accept_burst"), &SteamMultiplayerPeer::get_accept_burst);
+	ClassDB::bind_method(D_METHOD("set_max_pending_accepts", "max_pending_accepts"), &SteamMultiplayerPeer::set_max_pending_accepts);
+	ClassDB::bind_method(D_METHOD("get_max_pending_accepts"), &SteamMultiplayerPeer::get_max_pending_accepts);
+	ClassDB::bind_method(D_METHOD("get_pending_accept_count"), &SteamMultiplayerPeer::get_pending_accept_count);
+	ClassDB::bind_method(D_METHOD("get_rejected_connection_count"), &SteamMultiplayerPeer::get_rejected_connection_count);
+	ClassDB::bind_method(D_METHOD("prewarm"), &SteamMultiplayerPeer::prewarm);
+	ClassDB::bind_method(D_METHOD("_on_relay_network_ready"), &SteamMultiplayerPeer::_on_relay_network_ready);
+	ClassDB::bind_method(D_METHOD("is_relay_network_ready"), &SteamMultiplayerPeer::is_relay_network_ready);
+	ClassDB::bind_method(D_METHOD("get_cached_ping_location"), &SteamMultiplayerPeer::get_cached_ping_location);
+	ClassDB::bind_method(D_METHOD("set_ping_location_cache_path", "path"), &SteamMultiplayerPeer::set_ping_location_cache_path);
+	ClassDB::bind_method(D_METHOD("get_ping_location_cache_path"), &SteamMultiplayerPeer::get_ping_location_cache_path);
+	ClassDB::bind_method(D_METHOD("set_target_group", "group"), &SteamMultiplayerPeer::set_target_group);
+	ClassDB::bind_method(D_METHOD("get_target_group"), &SteamMultiplayerPeer::get_target_group);
+	ClassDB::bind_method(D_METHOD("add_peer_to_group", "group", "peer_id"), &SteamMultiplayerPeer::add_peer_to_group);
+	ClassDB::bind_method(D_METHOD("remove_peer_from_group", "group", "peer_id"), &SteamMultiplayerPeer::remove_peer_from_group);
+	ClassDB::bind_method(D_METHOD("clear_group", "group"), &SteamMultiplayerPeer::clear_group);
+	ClassDB::bind_method(D_METHOD("get_group_peers", "group"), &SteamMultiplayerPeer::get_group_peers);
 
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "listen_socket"), "set_listen_socket", "get_listen_socket");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "no_nagle"), "set_no_nagle", "get_no_nagle");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "no_delay"), "set_no_delay", "get_no_delay");
 	// ADD_PROPERTY(PropertyInfo(Variant::BOOL, "as_relay"), "set_as_relay", "get_as_relay");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "configs"), "set_configs", "get_configs");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "send_priority"), "set_send_priority", "get_send_priority");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "send_ttl"), "set_send_ttl", "get_send_ttl");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "send_key"), "set_send_key", "get_send_key");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "native_relay"), "set_native_relay", "get_native_relay");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "stream_coalescing"), "set_stream_coalescing", "get_stream_coalescing");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "send_stream"), "set_send_stream", "get_send_stream");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "collect_histograms"), "set_collect_histograms", "get_collect_histograms");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "jitter_stream"), "set_jitter_stream", "get_jitter_stream");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "jitter_min_delay"), "set_jitter_min_delay", "get_jitter_min_delay");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "jitter_max_delay"), "set_jitter_max_delay", "get_jitter_max_delay");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "split_unreliable"), "set_split_unreliable", "get_split_unreliable");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "split_timeout"), "set_split_timeout", "get_split_timeout");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "deliver_partial_messages"), "set_deliver_partial_messages", "get_deliver_partial_messages");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "send_queue_budget"), "set_send_queue_budget", "get_send_queue_budget");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "reconnect_grace_time"), "set_reconnect_grace_time", "get_reconnect_grace_time");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_clients"), "set_max_clients", "get_max_clients");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "accept_rate"), "set_accept_rate", "get_accept_rate");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "accept_burst"), "set_accept_burst", "get_accept_burst");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_pending_accepts"), "set_max_pending_accepts", "get_max_pending_accepts");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "ping_location_cache_path"), "set_ping_location_cache_path", "get_ping_location_cache_path");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "adaptive_rate"), "set_adaptive_rate", "get_adaptive_rate");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "adaptive_rate_interval"), "set_adaptive_rate_interval", "get_adaptive_rate_interval");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "adaptive_send_rate_min"), "set_adaptive_send_rate_min", "get_adaptive_send_rate_min");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "adaptive_send_rate_max"), "set_adaptive_send_rate_max", "get_adaptive_send_rate_max");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "adaptive_target_queue_time"), "set_adaptive_target_queue_time", "get_adaptive_target_queue_time");
 
 	// NETWORKING SOCKETS SIGNALS ///////////////
 	ADD_SIGNAL(MethodInfo("network_connection_status_changed", PropertyInfo(Variant::INT, "connect_handle"), PropertyInfo(Variant::DICTIONARY, "connection"), PropertyInfo(Variant::INT, "old_state")));
+	ADD_SIGNAL(MethodInfo("peer_reconnecting", PropertyInfo(Variant::INT, "peer_id")));
+	ADD_SIGNAL(MethodInfo("peer_resumed", PropertyInfo(Variant::INT, "peer_id")));
+	ADD_SIGNAL(MethodInfo("mesh_link_changed", PropertyInfo(Variant::INT, "peer_id"), PropertyInfo(Variant::BOOL, "direct")));
+	ADD_SIGNAL(MethodInfo("relay_network_ready", PropertyInfo(Variant::STRING, "ping_location")));
 }
 
 const int SteamMultiplayerPeer::_get_steam_transfer_flag() {
-	MultiplayerPeer::TransferMode transfer_mode = get_transfer_mode();
+	return _get_steam_transfer_flag(get_transfer_mode());
+}
 
+const int SteamMultiplayerPeer::_get_steam_transfer_flag(MultiplayerPeer::TransferMode transfer_mode) {
 	int32_t flags = (k_nSteamNetworkingSend_NoNagle * no_nagle) | (k_nSteamNetworkingSend_NoDelay * no_delay);
 
 	switch (transfer_mode) {
@@ -319,36 +898,74 @@ const int SteamMultiplayerPeer::_get_steam_transfer_flag() {
 
 // NETWORKING SOCKETS CALLBACKS /////////////////
 //
+// Handles the changes SteamNetworkingHub queued, in order. Signals may close the peer, which
+// drops the rest.
+void SteamMultiplayerPeer::_process_status_events() {
+	LocalVector<SteamNetConnectionStatusChangedCallback_t> events;
+	SWAP(events, status_events);
+	for (uint32_t i = 0; i < events.size() && _is_active(); i++) {
+		_process_status_event(&events[i]);
+		ESteamNetworkingConnectionState state = events[i].m_info.m_eState;
+		if (state == k_ESteamNetworkingConnectionState_ClosedByPeer || state == k_ESteamNetworkingConnectionState_ProblemDetectedLocally) {
+			SteamNetworkingHub::get_singleton()->release_connection(events[i].m_hConn);
+			accepting.erase(events[i].m_hConn);
+			pending_accepts.erase(events[i].m_hConn);
+			awaiting_session.erase(events[i].m_hConn);
+		}
+	}
+}
+
+const SteamNetworkingConfigValue_t *SteamMultiplayerPeer::_get_connection_options() {
+	connection_options.clear();
+	const SteamNetworkingConfigValue_t *compiled = configs->get_compiled_options();
+	for (int i = 0; i < configs->get_compiled_size(); i++) {
+		connection_options.push_back(compiled[i]);
+	}
+	SteamNetworkingConfigValue_t callback;
+	callback.SetPtr(k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged, (void *)&SteamNetworkingHub::connection_status_changed);
+	connection_options.push_back(callback);
+	return connection_options.ptr();
+}
+
+int SteamMultiplayerPeer::_get_connection_option_count() const {
+	return configs->get_compiled_size() + 1;
+}
+
+// Closes a connection Steam won't report on again and drops its hub claim.
+void SteamMultiplayerPeer::_close_connection_handle(HSteamNetConnection p_connection, int p_reason, const char *p_debug) {
+	SteamNetworkingSockets()->CloseConnection(p_connection, p_reason, p_debug, false);
+	SteamNetworkingHub::get_singleton()->release_connection(p_connection);
+}
+
 //! This callback is posted whenever a connection is created, destroyed, or
 //! changes state. The m_info field will contain a complete description of the
 //! connection at the time the change occurred and the callback was posted. In
 //! particular, m_info.m_eState will have the new connection state.
-void SteamMultiplayerPeer::network_connection_status_changed(SteamNetConnectionStatusChangedCallback_t *call_data) {
+void SteamMultiplayerPeer::_process_status_event(const SteamNetConnectionStatusChangedCallback_t *call_data) {
+	STEAM_TRACE_ZONE("SteamMultiplayerPeer::_process_status_event");
+	STEAM_TRACE_VALUE(call_data->m_info.m_eState);
 	// Connection handle.
 	uint64_t connect_handle = call_data->m_hConn;
 
 	// Full connection info.
 	SteamNetConnectionInfo_t connection_info = call_data->m_info;
 
-	uint64_t steam_id = call_data->m_info.m_identityRemote.GetSteamID().ConvertToUint64();
+	uint64_t steam_id = _identity_key(call_data->m_info.m_identityRemote);
 
 	// A new connection arrives on a listen socket.
 	if (connection_info.m_hListenSocket && call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_None && call_data->m_info.m_eState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connecting) {
-		EResult res = SteamNetworkingSockets()->AcceptConnection(connect_handle);
-		if (res != k_EResultOK) {
-			SteamNetworkingSockets()->CloseConnection(connect_handle, k_ESteamNetConnectionEnd_AppException_Generic, "Failed to accept connection", false);
-			return;
-		}
+		_admit_connection(connect_handle, steam_id);
+		return;
 	}
 
 	// A connection you initiated has been accepted by the remote host.
 	if ((call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connecting ||
 				call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_FindingRoute) &&
 			call_data->m_info.m_eState == k_ESteamNetworkingConnectionState_Connected) {
-		add_connection(steam_id, call_data->m_hConn);
-		if (!_is_server()) {
-			connection_status = ConnectionStatus::CONNECTION_CONNECTED;
-			Error err = connections_by_steamId64[steam_id]->send_peer(unique_id);
+		if (ip_transport && active_mode == MODE_SERVER) {
+			awaiting_session[call_data->m_hConn] = steam_id; // registered in _accept_session_token
+		} else {
+			_on_connection_established(steam_id, call_data->m_hConn);
 		}
 	}
 
@@ -358,22 +975,7 @@ void SteamMultiplayerPeer::network_connection_status_changed(SteamNetConnectionS
 	if ((call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connecting ||
 				call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connected) &&
 			call_data->m_info.m_eState == k_ESteamNetworkingConnectionState_ClosedByPeer) {
-		if (!_is_server()) {
-			if (connection_status == CONNECTION_CONNECTED) {
-				emit_signal("peer_disconnected", 1);
-			}
-			close();
-		} else {
-			if (connections_by_steamId64.has(steam_id)) {
-				Ref<SteamConnection> connection = connections_by_steamId64[steam_id];
-				uint32_t peer_id = connection->peer_id;
-				if (peer_id != -1) {
-					emit_signal("peer_disconnected", peer_id);
-					peerId_to_steamId.erase(peer_id);
-				}
-				connections_by_steamId64.erase(steam_id);
-			}
-		}
+		_handle_connection_closed(call_data, steam_id);
 		return;
 	}
 
@@ -381,110 +983,501 @@ void SteamMultiplayerPeer::network_connection_status_changed(SteamNetConnectionS
 	if ((call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connecting ||
 				call_data->m_eOldState == ESteamNetworkingConnectionState::k_ESteamNetworkingConnectionState_Connected) &&
 			call_data->m_info.m_eState == k_ESteamNetworkingConnectionState_ProblemDetectedLocally) {
-		if (!_is_server()) {
-			if (connection_status == CONNECTION_CONNECTED) {
-				emit_signal("peer_disconnected", 1);
-			}
-			close();
-		} else {
-			if (connections_by_steamId64.has(steam_id)) {
-				Ref<SteamConnection> connection = connections_by_steamId64[steam_id];
-				uint32_t peer_id = connection->peer_id;
-				if (peer_id != -1) {
-					emit_signal("peer_disconnected", peer_id);
-					peerId_to_steamId.erase(peer_id);
-				}
-				connections_by_steamId64.erase(steam_id);
-			}
+		_handle_connection_closed(call_data, steam_id);
+		return;
+	}
+}
+
+void SteamMultiplayerPeer::_handle_connection_closed(const SteamNetConnectionStatusChangedCallback_t *call_data, uint64_t steam_id) {
+	int64_t slot = _find_slot(call_data->m_info.m_nUserData, steam_id);
+
+	if (!_is_server()) {
+		if (mesh && steam_id != remote_steam_id) {
+			_close_mesh_link(call_data, slot);
+			return;
+		}
+		if (slot == -1 && parked_slots.has(steam_id)) {
+			// A reconnect attempt failed, _poll retries until the grace window runs out.
+			_close_connection_handle(call_data->m_hConn, k_ESteamNetConnectionEnd_App_Generic, "Reconnect failed");
+			connection = k_HSteamNetConnection_Invalid;
+			return;
+		}
+		if (slot != -1 && _should_park(call_data, slot)) {
+			_park_connection(slot);
+			connection = k_HSteamNetConnection_Invalid;
+			emit_signal("peer_reconnecting", 1);
+			return;
+		}
+		if (connection_status == CONNECTION_CONNECTED) {
+			emit_signal("peer_disconnected", 1);
 		}
+		close();
+		return;
+	}
+
+	if (slot == -1) {
+		if (awaiting_session.has(call_data->m_hConn)) {
+			_close_connection_handle(call_data->m_hConn, k_ESteamNetConnectionEnd_App_Generic, "Closed before the session token");
+		}
+		return;
+	}
+	int peer_id = connection_slots[slot].connection->peer_id;
+	if (_should_park(call_data, slot)) {
+		_park_connection(slot);
+		emit_signal("peer_reconnecting", peer_id);
 		return;
 	}
+	_remove_connection(slot);
+	if (peer_id != -1) {
+		if (mesh) {
+			_mesh_peer_left(steam_id);
+		}
+		emit_signal("peer_disconnected", peer_id);
+	}
+}
+
+#ifndef STEAM_PEER_GNS
+//! Posted when the relay network availability changes. Used to finish a pending prewarm.
+void SteamMultiplayerPeer::relay_network_status_changed(SteamRelayNetworkStatus_t *call_data) {
+	if (relay_prewarm_pending && call_data->m_eAvail == k_ESteamNetworkingAvailability_Current) {
+		_on_relay_network_ready();
+	}
 }
+#endif
 
 // GODOT MULTIPLAYER PEER UTILS  ///////////////////
 Ref<SteamConnection> SteamMultiplayerPeer::get_connection_by_peer(int peer_id) {
-	if (peerId_to_steamId.has(peer_id))
-		return peerId_to_steamId[peer_id];
+	HashMap<int32_t, uint32_t>::ConstIterator E = slot_by_peer_id.find(peer_id);
+	if (E) {
+		return connection_slots[E->value].connection;
+	}
 
 	return nullptr;
 }
 
 void SteamMultiplayerPeer::add_connection(const uint64_t steam_id, HSteamNetConnection connection) {
-	ERR_FAIL_COND_MSG(steam_id == SteamUser()->GetSteamID().ConvertToUint64(), "Cannot add self as a new peer.");
+	ERR_FAIL_COND_MSG(steam_id == _local_steam_id(), "Cannot add self as a new peer.");
 
 	Ref<SteamConnection> connection_data = Ref<SteamConnection>(memnew(SteamConnection(steam_id)));
 	connection_data->steam_connection = connection;
-	connections_by_steamId64[steam_id] = connection_data;
-}
-
-void SteamMultiplayerPeer::_process_message(const SteamNetworkingMessage_t *msg) {
-	ERR_FAIL_COND_MSG(msg->GetSize() > MAX_STEAM_PACKET_SIZE, "Packet too large to send!");
+	connection_data->max_pending_bytes = send_queue_budget;
 
-	Ref<SteamPacketPeer> packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer));
-	packet->sender = msg->m_identityPeer.GetSteamID64();
-	packet->size = msg->GetSize();
-	packet->transfer_mode = msg->m_nFlags;
+	uint32_t slot;
+	if (free_slots.size() > 0) {
+		slot = free_slots[free_slots.size() - 1];
+		free_slots.resize(free_slots.size() - 1);
+	} else {
+		slot = connection_slots.size();
+		connection_slots.push_back(ConnectionSlot());
+	}
+	connection_slots[slot].connection = connection_data;
+	slot_by_steam_id[steam_id] = slot;
+	split_mtu = 0;
 
-	uint8_t *rawData = (uint8_t *)msg->GetData();
-	memcpy(packet->data, rawData, packet->size);
-	incoming_packets.push_back(packet);
+	SteamNetworkingSockets()->SetConnectionUserData(connection, _make_slot_user_data(slot, connection_slots[slot].generation));
+	SteamNetworkingHub::get_singleton()->claim_connection(connection, this);
 }
 
-void SteamMultiplayerPeer::_process_ping(const SteamNetworkingMessage_t *msg) {
-	ERR_FAIL_COND_MSG(sizeof(SteamConnection::SetupPeerPayload) != msg->GetSize(), "Payload is the wrong size for a ping.");
-
-	SteamConnection::SetupPeerPayload *receive = (SteamConnection::SetupPeerPayload *)msg->GetData();
-	uint64_t steam_id = msg->m_identityPeer.GetSteamID64();
-
-	Ref<SteamConnection> connection = connections_by_steamId64[steam_id];
+// Resolves a connection slot from Steam connection user data. Falls back to the Steam ID
+// for messages and callbacks stamped before the user data was assigned.
+int64_t SteamMultiplayerPeer::_find_slot(int64_t p_user_data, uint64_t p_steam_id) const {
+	int64_t slot = _find_slot_by_user_data(p_user_data);
+	if (slot != -1) {
+		return slot;
+	}
+	HashMap<uint64_t, uint32_t>::ConstIterator E = slot_by_steam_id.find(p_steam_id);
+	if (E) {
+		return E->value;
+	}
+	return -1;
+}
 
-	if (receive->peer_id != -1) {
-		if (connection->peer_id == -1) {
-			set_steam_id_peer(steam_id, receive->peer_id);
-		}
-		if (_is_server()) {
-			Error err = connection->send_peer(unique_id);
-			emit_signal("peer_connected", connection->peer_id);
-		} else {
-			emit_signal("peer_connected", connection->peer_id);
+int64_t SteamMultiplayerPeer::_find_slot_by_user_data(int64_t p_user_data) const {
+	if (p_user_data != -1) {
+		uint32_t slot = (uint32_t)(p_user_data & 0xFFFFFFFF);
+		uint32_t generation = (uint32_t)(p_user_data >> 32);
+		if (slot < connection_slots.size() && connection_slots[slot].generation == generation && connection_slots[slot].connection.is_valid()) {
+			return slot;
 		}
 	}
+	return -1;
 }
 
-uint64_t SteamMultiplayerPeer::get_steam64_from_peer_id(const uint32_t peer_id) const {
-	if (peer_id == this->unique_id) {
-		return SteamUser()->GetSteamID().ConvertToUint64();
-	} else if (peerId_to_steamId.has(peer_id)) {
-		return peerId_to_steamId[peer_id]->steam_id;
-	} else
-		return -1;
+// Same as _find_slot, but only looks further when the user data misses: by Steam ID, else by
+// handle. IP connections may be keyed by a session token their identity doesn't carry.
+int64_t SteamMultiplayerPeer::_find_message_slot(const SteamNetworkingMessage_t *p_message) const {
+	int64_t slot = _find_slot_by_user_data(p_message->m_nConnUserData);
+	if (slot != -1) {
+		return slot;
+	}
+	uint64_t steam_id = p_message->m_identityPeer.GetSteamID64();
+	if (steam_id != 0) {
+		return _find_slot(-1, steam_id);
+	}
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && connection->steam_connection == p_message->m_conn) {
+			return i;
+		}
+	}
+	return -1;
 }
 
-uint32_t SteamMultiplayerPeer::get_peer_id_from_steam64(const uint64_t steamid) const {
-	if (steamid == SteamUser()->GetSteamID().ConvertToUint64()) {
-		return this->unique_id;
-	} else if (connections_by_steamId64.has(steamid)) {
-		return connections_by_steamId64[steamid]->peer_id;
-	} else
-		return -1;
+Ref<SteamConnection> SteamMultiplayerPeer::_get_connection_by_slot(int64_t p_slot) const {
+	if (p_slot < 0 || p_slot >= connection_slots.size()) {
+		return nullptr;
+	}
+	return connection_slots[p_slot].connection;
 }
 
-void SteamMultiplayerPeer::set_steam_id_peer(uint64_t steam_id, int peer_id) {
-	ERR_FAIL_COND_MSG(steam_id == SteamUser()->GetSteamID().ConvertToUint64(), "Cannot add self as a new peer.");
-	ERR_FAIL_COND_MSG(connections_by_steamId64.has(steam_id) == false, "Steam ID missing");
-
-	Ref<SteamConnection> con = connections_by_steamId64[steam_id];
-	if (con->peer_id == -1) {
-		con->peer_id = peer_id;
-		peerId_to_steamId[peer_id] = con;
-	} else if (con->peer_id == peer_id) {
-		//peer already exists, so nothing happens
-	} else {
-		WARN_PRINT(String("Steam ID detected with wrong peer ID!"));
+void SteamMultiplayerPeer::_remove_connection(uint32_t p_slot) {
+	ERR_FAIL_UNSIGNED_INDEX(p_slot, connection_slots.size());
+	ConnectionSlot &entry = connection_slots[p_slot];
+	ERR_FAIL_COND(entry.connection.is_null());
+	split_mtu = 0;
+	if (entry.connection->steam_connection != k_HSteamNetConnection_Invalid) {
+		SteamNetworkingHub::get_singleton()->release_connection(entry.connection->steam_connection);
 	}
-}
 
-void SteamMultiplayerPeer::set_listen_socket(const int listen_socket) {
+	if (entry.connection->peer_id != -1) {
+		if (receive_streams.size() > 0) {
+			LocalVector<uint64_t> streams;
+			for (const KeyValue<uint64_t, ReceiveStream> &E : receive_streams) {
+				if ((E.key >> 16) == (uint32_t)entry.connection->peer_id) {
+					streams.push_back(E.key);
+				}
+			}
+			for (uint32_t i = 0; i < streams.size(); i++) {
+				receive_streams.erase(streams[i]);
+			}
+		}
+		if (split_messages.size() > 0) {
+			LocalVector<uint64_t> messages;
+			for (const KeyValue<uint64_t, SplitMessage> &E : split_messages) {
+				if ((E.key >> 16) == (uint32_t)entry.connection->peer_id) {
+					messages.push_back(E.key);
+				}
+			}
+			for (uint32_t i = 0; i < messages.size(); i++) {
+				split_messages.erase(messages[i]);
+			}
+		}
+		jitter_buffers.erase(entry.connection->peer_id);
+		slot_by_peer_id.erase(entry.connection->peer_id);
+		for (KeyValue<int32_t, HashSet<int32_t>> &E : peer_groups) {
+			E.value.erase(entry.connection->peer_id);
+		}
+	}
+	HashMap<uint64_t, uint32_t>::Iterator E = slot_by_steam_id.find(entry.connection->steam_id);
+	if (E && E->value == p_slot) {
+		slot_by_steam_id.remove(E);
+	}
+	entry.connection.unref();
+	// Invalidates any user data still attached to in-flight messages for this slot.
+	entry.generation++;
+	free_slots.push_back(p_slot);
+}
+
+void SteamMultiplayerPeer::_clear_connections() {
+	connection_slots.clear();
+	free_slots.clear();
+	slot_by_steam_id.clear();
+	slot_by_peer_id.clear();
+	peer_groups.clear();
+	parked_slots.clear();
+	receive_streams.clear();
+	send_stream_sequences.clear();
+	jitter_buffers.clear();
+	split_messages.clear();
+	status_events.clear();
+	pending_accepts.clear();
+	accepting.clear();
+	awaiting_session.clear();
+	accept_tokens_at = 0;
+	for (uint32_t i = 0; i < incoming_messages.size(); i++) {
+		incoming_messages[i]->Release();
+	}
+	incoming_messages.clear();
+	split_mtu = 0;
+	SteamNetworkingHub::get_singleton()->release_peer(this);
+}
+
+void SteamMultiplayerPeer::_process_message(const SteamNetworkingMessage_t *msg, const Ref<SteamConnection> &sender) {
+	ERR_FAIL_COND_MSG(msg->GetSize() > MAX_STEAM_PACKET_SIZE, "Packet too large to send!");
+	STEAM_TRACE_ZONE("SteamMultiplayerPeer::_process_message");
+	STEAM_TRACE_VALUE(msg->GetSize());
+
+	const uint8_t *rawData = (const uint8_t *)msg->GetData();
+	uint32_t size = msg->GetSize();
+	int32_t peer_id = sender->peer_id;
+	if (native_relay) {
+		ERR_FAIL_COND_MSG(size < RELAY_HEADER_SIZE, "Packet too small for a relay header.");
+		if (active_mode == MODE_CLIENT && sender->peer_id == 1) {
+			// The host writes the original sender into the header, or 0 for its mesh announcements.
+			// Direct mesh links are trusted by connection instead.
+			peer_id = (int32_t)(rawData[0] | (rawData[1] << 8) | (rawData[2] << 16) | ((uint32_t)rawData[3] << 24));
+			if (peer_id == 0) {
+				ERR_FAIL_COND_MSG(!mesh, "Received a mesh announcement outside of a mesh session.");
+				_handle_mesh_control(rawData + RELAY_HEADER_SIZE, size - RELAY_HEADER_SIZE);
+				return;
+			}
+		}
+		rawData += RELAY_HEADER_SIZE;
+		size -= RELAY_HEADER_SIZE;
+	}
+	uint16_t stream = 0;
+	uint16_t sequence = 0;
+	uint32_t sent = 0;
+	if (stream_coalescing && !(msg->m_nFlags & k_nSteamNetworkingSend_Reliable)) {
+		ERR_FAIL_COND_MSG(size < STREAM_HEADER_SIZE, "Unreliable packet too small for a stream header.");
+		stream = rawData[0] | (rawData[1] << 8);
+		sequence = rawData[2] | (rawData[3] << 8);
+		rawData += STREAM_HEADER_SIZE;
+		size -= STREAM_HEADER_SIZE;
+		if (stream != 0 && stream == jitter_stream) {
+			ERR_FAIL_COND_MSG(size < JITTER_HEADER_SIZE, "Jitter stream packet too small for a timestamp.");
+			sent = rawData[0] | (rawData[1] << 8) | (rawData[2] << 16) | ((uint32_t)rawData[3] << 24);
+			rawData += JITTER_HEADER_SIZE;
+			size -= JITTER_HEADER_SIZE;
+		}
+	}
+
+	uint64_t steam_sender = peer_id == sender->peer_id ? sender->steam_id : 0;
+	Ref<SteamPacketPeer> packet;
+	if (split_unreliable && !(msg->m_nFlags & k_nSteamNetworkingSend_Reliable)) {
+		ERR_FAIL_COND_MSG(size < 1, "Unreliable packet too small for a part count.");
+		uint8_t count = rawData[0];
+		if (count < 2) {
+			rawData += 1;
+			size -= 1;
+		} else {
+			ERR_FAIL_COND_MSG(size < SPLIT_PART_HEADER_SIZE, "Split part too small for its header.");
+			uint8_t index = rawData[1];
+			uint16_t message_id = rawData[2] | (rawData[3] << 8);
+			uint16_t part_size = rawData[4] | (rawData[5] << 8);
+			rawData += SPLIT_PART_HEADER_SIZE;
+			size -= SPLIT_PART_HEADER_SIZE;
+			ERR_FAIL_COND_MSG(index >= count || part_size == 0 || (uint32_t)count * part_size > MAX_STEAM_PACKET_SIZE, "Malformed split part header.");
+			ERR_FAIL_COND_MSG(size > part_size || (index < count - 1 && size != part_size), "Split part has the wrong size.");
+
+			uint64_t key = ((uint64_t)(uint32_t)peer_id << 16) | message_id;
+			SplitMessage &split = split_messages[key];
+			if (split.packet.is_null() || split.count != count || split.part_size != part_size) {
+				split = SplitMessage();
+				split.packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer));
+				split.packet->sender = steam_sender;
+				split.packet->peer_id = peer_id;
+				split.packet->size = (uint32_t)count * part_size;
+				split.packet->transfer_mode = msg->m_nFlags;
+				split.packet->channel = stream;
+				split.count = count;
+				split.part_size = part_size;
+				split.sequence = sequence;
+				split.sent = sent;
+				split.started = msg->m_usecTimeReceived;
+			}
+			uint64_t bit = 1ULL << (index & 63);
+			if (split.received_mask[index >> 6] & bit) {
+				return; // duplicate
+			}
+			split.received_mask[index >> 6] |= bit;
+			split.received++;
+			memcpy(split.packet->data + (uint32_t)index * part_size, rawData, size);
+			if (index == count - 1) {
+				split.packet->size = (uint32_t)index * part_size + size;
+			}
+			if (split.received < split.count) {
+				return;
+			}
+			packet = split.packet;
+			packet->received_at = msg->m_usecTimeReceived;
+			sequence = split.sequence;
+			sent = split.sent;
+			split_messages.erase(key);
+		}
+	}
+
+	if (packet.is_null()) {
+		packet = Ref<SteamPacketPeer>(memnew(SteamPacketPeer));
+		packet->sender = steam_sender;
+		packet->peer_id = peer_id;
+		packet->size = size;
+		packet->transfer_mode = msg->m_nFlags;
+		packet->channel = stream;
+		packet->received_at = msg->m_usecTimeReceived;
+		memcpy(packet->data, rawData, size);
+	}
+	if (collect_histograms) {
+		_get_channel_histograms(peer_id, stream).received_size.record(packet->size);
+	}
+	_deliver_packet(packet, sequence, sent);
+}
+
+// Queues a received packet, through the jitter buffer or stream coalescing when it has a stream.
+void SteamMultiplayerPeer::_deliver_packet(const Ref<SteamPacketPeer> &p_packet, uint16_t p_sequence, uint32_t p_sent) {
+	uint16_t stream = p_packet->channel;
+	if (stream == 0) {
+		incoming_packets.push_back(p_packet);
+		return;
+	}
+	if (stream == jitter_stream) {
+		_jitter_push(p_packet, p_sequence, p_sent, p_packet->received_at);
+		return;
+	}
+
+	ReceiveStream &state = receive_streams[((uint64_t)(uint32_t)p_packet->peer_id << 16) | stream];
+	if (state.received && (int16_t)(p_sequence - state.last_sequence) <= 0) {
+		// Older than what was already delivered, or a duplicate.
+		coalesced_packets++;
+		return;
+	}
+	state.received = true;
+	state.last_sequence = p_sequence;
+	// Nothing drains incoming_packets during _poll, so an element queued this poll is still there.
+	if (state.poll == poll_count && state.pending) {
+		state.pending->erase();
+		coalesced_packets++;
+	}
+	state.pending = incoming_packets.push_back(p_packet);
+	state.poll = poll_count;
+}
+
+// Peer ids are derived from Steam IDs on both ends, so a connection is registered as soon
+// as Steam reports it connected instead of after a setup payload round trip.
+void SteamMultiplayerPeer::_on_connection_established(uint64_t steam_id, HSteamNetConnection p_connection) {
+	accepting.erase(p_connection);
+	bool mesh_link = mesh && active_mode == MODE_CLIENT && steam_id != remote_steam_id;
+
+	// Checked before add_connection, which would repoint slot_by_steam_id at the new slot.
+	HashMap<uint64_t, uint32_t>::ConstIterator S = slot_by_steam_id.find(steam_id);
+	if (S) {
+		if (!_is_server()) {
+			_close_connection_handle(p_connection, k_ESteamNetConnectionEnd_AppException_Generic, "Already connected");
+			return;
+		}
+		int32_t peer_id = connection_slots[S->value].connection->peer_id;
+		if (_is_session_key(steam_id) && reconnect_grace_time > 0 && peer_id != -1) {
+			// The client redialed before the host saw the old connection drop. Parked here,
+			// resumed below.
+			_park_connection(S->value);
+			emit_signal("peer_reconnecting", peer_id);
+		} else {
+			_drop_stale_connection(S->value);
+		}
+		if (!_is_active()) {
+			return;
+		}
+	}
+	if (!mesh_link && !parked_slots.has(steam_id)) {
+		int32_t peer_id = _is_server() ? _derive_peer_id(steam_id) : 1;
+		if (slot_by_peer_id.has(peer_id)) {
+			// Two Steam IDs hashing to the same peer id. The one already connected keeps it.
+			_close_connection_handle(p_connection, k_ESteamNetConnectionEnd_AppException_Generic, "Peer id already in use");
+			ERR_FAIL_MSG(vformat("Peer id %d derived from Steam ID %d is already in use.", peer_id, (int64_t)steam_id));
+		}
+	}
+
+	add_connection(steam_id, p_connection);
+	int64_t slot = _find_slot(-1, steam_id);
+	ERR_FAIL_COND(slot == -1);
+	if (mesh_link) {
+		_accept_mesh_link(steam_id, p_connection, slot);
+		return;
+	}
+	if (ip_transport && active_mode == MODE_CLIENT) {
+		_send_session_token(p_connection); // ahead of anything resent below
+	}
+
+	HashMap<uint64_t, uint32_t>::Iterator P = parked_slots.find(steam_id);
+	if (P) {
+		Ref<SteamConnection> resumed = _resume_parked(P->value, slot);
+		if (resumed->resend_pending() != OK) {
+			WARN_PRINT(vformat("Could not resend queued packets to resumed peer %d, they stay queued.", resumed->peer_id));
+		}
+		emit_signal("peer_resumed", resumed->peer_id);
+		return;
+	}
+
+	int32_t peer_id = active_mode == MODE_SERVER ? _derive_peer_id(steam_id) : 1;
+	set_steam_id_peer(steam_id, peer_id);
+	if (ip_transport) {
+		if (active_mode == MODE_SERVER) {
+			_send_assigned_peer_id(p_connection, peer_id);
+		} else {
+			awaiting_peer_id = true;
+			return; // connected once the host's peer id message arrives, see _accept_assigned_peer_id
+		}
+	}
+	if (!_is_server()) {
+		connection_status = ConnectionStatus::CONNECTION_CONNECTED;
+	} else if (mesh) {
+		_mesh_peer_joined(connection_slots[slot].connection);
+	}
+	emit_signal("peer_connected", peer_id);
+}
+
+// The same Steam ID connected again while its old connection still looks alive, e.g. a
+// client that restarted before Steam timed the old one out. The old peer disconnects and
+// the new connection joins as usual.
+void SteamMultiplayerPeer::_drop_stale_connection(uint32_t p_slot) {
+	Ref<SteamConnection> stale = connection_slots[p_slot].connection;
+	int32_t peer_id = stale->peer_id;
+	_close_connection_handle(stale->steam_connection, k_ESteamNetConnectionEnd_App_Generic, "Replaced by a new connection");
+	stale->steam_connection = k_HSteamNetConnection_Invalid;
+	_remove_connection(p_slot);
+	if (peer_id != -1) {
+		if (mesh) {
+			_mesh_peer_left(stale->steam_id);
+		}
+		emit_signal("peer_disconnected", peer_id);
+	}
+}
+
+// Maps a Steam ID to a stable peer id in [2, 2^31). 1 is reserved for the server.
+int32_t SteamMultiplayerPeer::_derive_peer_id(uint64_t steam_id) {
+	int32_t peer_id = (int32_t)(hash_murmur3_one_64(steam_id) & 0x7FFFFFFF);
+	return peer_id < 2 ? peer_id + 2 : peer_id;
+}
+
+uint64_t SteamMultiplayerPeer::get_steam64_from_peer_id(const uint32_t peer_id) const {
+	if (peer_id == this->unique_id) {
+		return _local_steam_id();
+	} else if (slot_by_peer_id.has(peer_id)) {
+		return connection_slots[slot_by_peer_id[peer_id]].connection->steam_id;
+	} else if (mesh_peers.has(peer_id)) {
+		return mesh_peers[peer_id];
+	} else
+		return -1;
+}
+
+uint32_t SteamMultiplayerPeer::get_peer_id_from_steam64(const uint64_t steamid) const {
+	if (steamid == _local_steam_id()) {
+		return this->unique_id;
+	} else if (slot_by_steam_id.has(steamid)) {
+		return connection_slots[slot_by_steam_id[steamid]].connection->peer_id;
+	} else if (mesh_peers.has(_derive_peer_id(steamid))) {
+		return _derive_peer_id(steamid);
+	} else
+		return -1;
+}
+
+void SteamMultiplayerPeer::set_steam_id_peer(uint64_t steam_id, int peer_id) {
+	ERR_FAIL_COND_MSG(steam_id == _local_steam_id(), "Cannot add self as a new peer.");
+	ERR_FAIL_COND_MSG(slot_by_steam_id.has(steam_id) == false, "Steam ID missing");
+
+	uint32_t slot = slot_by_steam_id[steam_id];
+	Ref<SteamConnection> con = connection_slots[slot].connection;
+	if (con->peer_id == -1) {
+		con->peer_id = peer_id;
+		slot_by_peer_id[peer_id] = slot;
+	} else if (con->peer_id == peer_id) {
+		//peer already exists, so nothing happens
+	} else {
+		WARN_PRINT(String("Steam ID detected with wrong peer ID!"));
+	}
+}
+
+void SteamMultiplayerPeer::set_listen_socket(const int listen_socket) {
 	this->listen_socket = listen_socket;
 }
 
@@ -494,8 +1487,11 @@ int SteamMultiplayerPeer::get_listen_socket() const {
 
 Dictionary SteamMultiplayerPeer::get_peer_map() {
 	Dictionary output;
-	for (HashMap<uint64_t, Ref<SteamConnection>>::ConstIterator E = connections_by_steamId64.begin(); E; ++E) {
-		output[E->value->peer_id] = E->value->steam_id;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid()) {
+			output[connection->peer_id] = connection->steam_id;
+		}
 	}
 	return output;
 }
@@ -543,3 +1539,1477 @@ void SteamMultiplayerPeer::clear_config(const SteamPeerConfig::SteamNetworkingCo
 void SteamMultiplayerPeer::clear_all_configs() {
 	configs->clear_all_configs();
 }
+
+Error SteamMultiplayerPeer::apply_configs_to_peer(int peer_id) {
+	ERR_FAIL_COND_V_MSG(!_is_active(), ERR_UNCONFIGURED, "The multiplayer instance isn't currently active.");
+	Ref<SteamConnection> connection = get_connection_by_peer(peer_id);
+	ERR_FAIL_COND_V_MSG(connection.is_null(), ERR_INVALID_PARAMETER, vformat("Invalid peer: %d", peer_id));
+	return configs->apply_to_connection(connection->steam_connection);
+}
+
+Error SteamMultiplayerPeer::apply_configs_to_all_peers() {
+	ERR_FAIL_COND_V_MSG(!_is_active(), ERR_UNCONFIGURED, "The multiplayer instance isn't currently active.");
+	Error result = OK;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid()) {
+			Error err = configs->apply_to_connection(connection->steam_connection);
+			if (err != OK) {
+				result = err;
+			}
+		}
+	}
+	return result;
+}
+
+// TARGET_GROUP_NONE (-1) clears the group and puts go back to target_peer.
+void SteamMultiplayerPeer::set_target_group(int32_t group) {
+	ERR_FAIL_COND_MSG(group < TARGET_GROUP_NONE, "Group ids must be non-negative, or -1 (TARGET_GROUP_NONE) to clear the target group.");
+	target_group = group;
+}
+
+int32_t SteamMultiplayerPeer::get_target_group() const {
+	return target_group;
+}
+
+void SteamMultiplayerPeer::add_peer_to_group(int32_t group, int32_t peer_id) {
+	ERR_FAIL_COND_MSG(group < 0, "Group ids must be non-negative.");
+	peer_groups[group].insert(peer_id);
+}
+
+void SteamMultiplayerPeer::remove_peer_from_group(int32_t group, int32_t peer_id) {
+	HashMap<int32_t, HashSet<int32_t>>::Iterator G = peer_groups.find(group);
+	if (G) {
+		G->value.erase(peer_id);
+	}
+}
+
+void SteamMultiplayerPeer::clear_group(int32_t group) {
+	peer_groups.erase(group);
+}
+
+PackedInt32Array SteamMultiplayerPeer::get_group_peers(int32_t group) const {
+	PackedInt32Array output;
+	HashMap<int32_t, HashSet<int32_t>>::ConstIterator G = peer_groups.find(group);
+	if (G) {
+		for (const int32_t &member : G->value) {
+			output.push_back(member);
+		}
+	}
+	return output;
+}
+
+// ADAPTIVE SEND RATE ///////////////////
+#define ADAPTIVE_RATE_MIN_SCALE 0.1f
+#define ADAPTIVE_RATE_BACKOFF 0.75f
+#define ADAPTIVE_RATE_GROWTH 0.05f
+#define ADAPTIVE_RATE_MIN_QUALITY 0.9f
+
+void SteamMultiplayerPeer::_update_adaptive_rates() {
+	int64_t target_queue_usec = (int64_t)adaptive_target_queue_time * 1000;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_null()) {
+			continue;
+		}
+		SteamNetConnectionRealTimeStatus_t status;
+		if (SteamNetworkingSockets()->GetConnectionRealTimeStatus(connection->steam_connection, &status, 0, nullptr) != k_EResultOK) {
+			continue;
+		}
+
+		// Back off multiplicatively when data queues up locally or the link is losing packets,
+		// recover additively otherwise.
+		float quality = MIN(status.m_flConnectionQualityLocal, status.m_flConnectionQualityRemote);
+		bool congested = status.m_usecQueueTime > target_queue_usec ||
+				(status.m_flConnectionQualityLocal >= 0 && status.m_flConnectionQualityRemote >= 0 && quality < ADAPTIVE_RATE_MIN_QUALITY);
+		if (congested) {
+			connection->update_rate = MAX(connection->update_rate * ADAPTIVE_RATE_BACKOFF, ADAPTIVE_RATE_MIN_SCALE);
+		} else {
+			connection->update_rate = MIN(connection->update_rate + ADAPTIVE_RATE_GROWTH, 1.0f);
+		}
+
+		int32_t send_rate = adaptive_send_rate_min + (int32_t)((adaptive_send_rate_max - adaptive_send_rate_min) * connection->update_rate);
+		// Skip the config call for changes below 5%, they are noise.
+		if (ABS(send_rate - connection->send_rate_max) * 20 < connection->send_rate_max) {
+			continue;
+		}
+		connection->send_rate_max = send_rate;
+		SteamNetworkingUtils()->SetConnectionConfigValueInt32(connection->steam_connection, k_ESteamNetworkingConfig_SendRateMin, MIN(adaptive_send_rate_min, send_rate));
+		SteamNetworkingUtils()->SetConnectionConfigValueInt32(connection->steam_connection, k_ESteamNetworkingConfig_SendRateMax, send_rate);
+	}
+}
+
+void SteamMultiplayerPeer::set_adaptive_rate(const bool new_adaptive_rate) {
+	adaptive_rate = new_adaptive_rate;
+}
+
+bool SteamMultiplayerPeer::get_adaptive_rate() const {
+	return adaptive_rate;
+}
+
+void SteamMultiplayerPeer::set_adaptive_rate_interval(const int32_t new_interval) {
+	ERR_FAIL_COND_MSG(new_interval < 1, "The adaptive rate interval must be at least one poll.");
+	adaptive_rate_interval = new_interval;
+}
+
+int32_t SteamMultiplayerPeer::get_adaptive_rate_interval() const {
+	return adaptive_rate_interval;
+}
+
+void SteamMultiplayerPeer::set_adaptive_send_rate_min(const int32_t new_rate) {
+	ERR_FAIL_COND_MSG(new_rate < 1 || new_rate > adaptive_send_rate_max, "The minimum send rate must be positive and not above the maximum.");
+	adaptive_send_rate_min = new_rate;
+}
+
+int32_t SteamMultiplayerPeer::get_adaptive_send_rate_min() const {
+	return adaptive_send_rate_min;
+}
+
+void SteamMultiplayerPeer::set_adaptive_send_rate_max(const int32_t new_rate) {
+	ERR_FAIL_COND_MSG(new_rate < adaptive_send_rate_min, "The maximum send rate can't be below the minimum.");
+	adaptive_send_rate_max = new_rate;
+}
+
+int32_t SteamMultiplayerPeer::get_adaptive_send_rate_max() const {
+	return adaptive_send_rate_max;
+}
+
+void SteamMultiplayerPeer::set_adaptive_target_queue_time(const int32_t new_time) {
+	ERR_FAIL_COND_MSG(new_time < 1, "The target queue time must be positive.");
+	adaptive_target_queue_time = new_time;
+}
+
+int32_t SteamMultiplayerPeer::get_adaptive_target_queue_time() const {
+	return adaptive_target_queue_time;
+}
+
+// Recommended share of the full update rate for this peer, from 0.1 (congested) to 1.
+float SteamMultiplayerPeer::get_peer_update_rate(int peer_id) {
+	Ref<SteamConnection> connection = get_connection_by_peer(peer_id);
+	ERR_FAIL_COND_V_MSG(connection.is_null(), 1.0, vformat("Invalid peer: %d", peer_id));
+	return connection->update_rate;
+}
+
+int32_t SteamMultiplayerPeer::get_peer_send_rate(int peer_id) {
+	Ref<SteamConnection> connection = get_connection_by_peer(peer_id);
+	ERR_FAIL_COND_V_MSG(connection.is_null(), 0, vformat("Invalid peer: %d", peer_id));
+	return connection->send_rate_max;
+}
+
+// SEND SCHEDULING ///////////////////
+void SteamMultiplayerPeer::set_send_priority(const int32_t new_priority) {
+	send_priority = new_priority;
+}
+
+int32_t SteamMultiplayerPeer::get_send_priority() const {
+	return send_priority;
+}
+
+void SteamMultiplayerPeer::set_send_ttl(const int32_t new_ttl) {
+	ERR_FAIL_COND_MSG(new_ttl < 0, "The send time-to-live can't be negative.");
+	send_ttl = new_ttl;
+}
+
+int32_t SteamMultiplayerPeer::get_send_ttl() const {
+	return send_ttl;
+}
+
+// Sticky like transfer_mode: set it back to 0 before sending unkeyed traffic.
+void SteamMultiplayerPeer::set_send_key(const uint64_t new_key) {
+	send_key = new_key;
+}
+
+uint64_t SteamMultiplayerPeer::get_send_key() const {
+	return send_key;
+}
+
+void SteamMultiplayerPeer::set_send_queue_budget(const int32_t new_budget) {
+	ERR_FAIL_COND_MSG(new_budget < 0, "The send queue budget can't be negative.");
+	send_queue_budget = new_budget;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		if (connection_slots[i].connection.is_valid()) {
+			connection_slots[i].connection->max_pending_bytes = new_budget;
+		}
+	}
+}
+
+int32_t SteamMultiplayerPeer::get_send_queue_budget() const {
+	return send_queue_budget;
+}
+
+// STREAM COALESCING ///////////////////
+void SteamMultiplayerPeer::set_stream_coalescing(const bool new_stream_coalescing) {
+	ERR_FAIL_COND_MSG(_is_active(), "Stream coalescing changes the wire format, set it before connecting.");
+	stream_coalescing = new_stream_coalescing;
+}
+
+bool SteamMultiplayerPeer::get_stream_coalescing() const {
+	return stream_coalescing;
+}
+
+// Stream for the following unreliable packets, 0 disables coalescing for them.
+void SteamMultiplayerPeer::set_send_stream(const int32_t new_stream) {
+	ERR_FAIL_COND_MSG(new_stream < 0 || new_stream > UINT16_MAX, "Stream ids must fit in 16 bits.");
+	send_stream = new_stream;
+}
+
+int32_t SteamMultiplayerPeer::get_send_stream() const {
+	return send_stream;
+}
+
+uint64_t SteamMultiplayerPeer::get_coalesced_packet_count() const {
+	return coalesced_packets;
+}
+
+// JITTER BUFFER ///////////////////
+void SteamMultiplayerPeer::set_jitter_stream(const int32_t new_stream) {
+	ERR_FAIL_COND_MSG(_is_active(), "The jitter stream changes the wire format, set it before connecting.");
+	ERR_FAIL_COND_MSG(new_stream < 0 || new_stream > UINT16_MAX, "Stream ids must fit in 16 bits.");
+	jitter_stream = new_stream;
+}
+
+int32_t SteamMultiplayerPeer::get_jitter_stream() const {
+	return jitter_stream;
+}
+
+void SteamMultiplayerPeer::set_jitter_min_delay(const int32_t new_delay) {
+	ERR_FAIL_COND(new_delay < 0);
+	jitter_min_delay = new_delay;
+}
+
+int32_t SteamMultiplayerPeer::get_jitter_min_delay() const {
+	return jitter_min_delay;
+}
+
+void SteamMultiplayerPeer::set_jitter_max_delay(const int32_t new_delay) {
+	ERR_FAIL_COND(new_delay < 0);
+	jitter_max_delay = new_delay;
+}
+
+int32_t SteamMultiplayerPeer::get_jitter_max_delay() const {
+	return jitter_max_delay;
+}
+
+// 0 until the peer has sent on the jitter stream.
+float SteamMultiplayerPeer::get_peer_jitter(int32_t peer_id) const {
+	HashMap<int32_t, JitterBuffer>::ConstIterator E = jitter_buffers.find(peer_id);
+	if (!E) {
+		return 0.0f;
+	}
+	return E->value.jitter / 1000.0f;
+}
+
+float SteamMultiplayerPeer::get_peer_playout_delay(int32_t peer_id) const {
+	HashMap<int32_t, JitterBuffer>::ConstIterator E = jitter_buffers.find(peer_id);
+	if (!E) {
+		return 0.0f;
+	}
+	return E->value.playout_delay / 1000.0f;
+}
+
+uint64_t SteamMultiplayerPeer::get_late_packet_count() const {
+	return late_packets;
+}
+
+// UNRELIABLE SPLITTING ///////////////////
+void SteamMultiplayerPeer::set_split_unreliable(const bool new_split_unreliable) {
+	ERR_FAIL_COND_MSG(_is_active(), "Unreliable splitting changes the wire format, set it before connecting.");
+	split_unreliable = new_split_unreliable;
+}
+
+bool SteamMultiplayerPeer::get_split_unreliable() const {
+	return split_unreliable;
+}
+
+// How long a split message waits for its missing parts before it is dropped or delivered partially.
+void SteamMultiplayerPeer::set_split_timeout(const int32_t new_timeout) {
+	ERR_FAIL_COND_MSG(new_timeout < 0, "The split timeout can't be negative.");
+	split_timeout = new_timeout;
+}
+
+int32_t SteamMultiplayerPeer::get_split_timeout() const {
+	return split_timeout;
+}
+
+void SteamMultiplayerPeer::set_deliver_partial_messages(const bool new_deliver_partial) {
+	deliver_partial_messages = new_deliver_partial;
+}
+
+bool SteamMultiplayerPeer::get_deliver_partial_messages() const {
+	return deliver_partial_messages;
+}
+
+// Whether the packet from the last get_packet is missing zero filled parts.
+bool SteamMultiplayerPeer::is_last_packet_partial() const {
+	return next_received_packet.is_valid() && next_received_packet->partial;
+}
+
+uint64_t SteamMultiplayerPeer::get_incomplete_message_count() const {
+	return incomplete_messages;
+}
+
+int32_t SteamMultiplayerPeer::_get_split_header_size(int p_flags) const {
+	return split_unreliable && !(p_flags & k_nSteamNetworkingSend_Reliable) ? 1 : 0;
+}
+
+// Smallest MTU_DataSize across live connections, so broadcasts are split once for all targets.
+int32_t SteamMultiplayerPeer::_get_split_mtu() {
+	if (split_mtu > 0) {
+		return split_mtu;
+	}
+	int32_t mtu = INT32_MAX;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_null() || connection->steam_connection == k_HSteamNetConnection_Invalid) {
+			continue;
+		}
+		int32 value = 0;
+		size_t value_size = sizeof(value);
+		ESteamNetworkingConfigDataType type;
+		ESteamNetworkingGetConfigValueResult result = SteamNetworkingUtils()->GetConfigValue(k_ESteamNetworkingConfig_MTU_DataSize, k_ESteamNetworkingConfig_Connection, connection->steam_connection, &type, &value, &value_size);
+		if (result >= k_ESteamNetworkingGetConfigValue_OK && value > 0) {
+			mtu = MIN(mtu, value);
+		}
+	}
+	split_mtu = mtu == INT32_MAX ? SPLIT_FALLBACK_MTU : mtu;
+	return split_mtu;
+}
+
+// p_buffer holds p_prefix_size bytes of relay and stream header, the part count byte and
+// p_size bytes of payload. Every part repeats the headers, so each is routed on its own.
+Error SteamMultiplayerPeer::_put_split(const uint8_t *p_buffer, int32_t p_prefix_size, int32_t p_size, int p_flags, uint16_t p_channel, bool p_relay_client) {
+	int32_t part_size = MIN(_get_split_mtu() - p_prefix_size - SPLIT_PART_HEADER_SIZE, UINT16_MAX);
+	int32_t count = part_size > 0 ? (p_size + part_size - 1) / part_size : 0;
+	if (count < 2 || count > UINT8_MAX || send_key != 0) {
+		// Too many parts to count, or keyed parts that would replace each other in the send
+		// queue. Leave the fragmenting to Steam.
+		return _route_packet(p_buffer, p_prefix_size + 1 + p_size, p_flags, p_channel, p_relay_client);
+	}
+
+	uint16_t message_id = ++split_message_id;
+	const uint8_t *payload = p_buffer + p_prefix_size + 1;
+	split_scratch.resize(p_prefix_size + SPLIT_PART_HEADER_SIZE + part_size);
+	uint8_t *w = split_scratch.ptr();
+	memcpy(w, p_buffer, p_prefix_size);
+	uint8_t *h = w + p_prefix_size;
+	h[0] = count;
+	h[2] = message_id & 0xFF;
+	h[3] = (message_id >> 8) & 0xFF;
+	h[4] = part_size & 0xFF;
+	h[5] = (part_size >> 8) & 0xFF;
+
+	Error returnValue = OK;
+	for (int32_t i = 0; i < count; i++) {
+		int32_t size = MIN(part_size, p_size - i * part_size);
+		h[1] = i;
+		memcpy(h + SPLIT_PART_HEADER_SIZE, payload + i * part_size, size);
+		Error errorCode = _route_packet(w, p_prefix_size + SPLIT_PART_HEADER_SIZE + size, p_flags, p_channel, p_relay_client);
+		if (errorCode != OK) {
+			returnValue = errorCode;
+		}
+	}
+	return returnValue;
+}
+
+// Messages still missing parts after split_timeout are dropped, or delivered with the gaps
+// zero filled when deliver_partial_messages is set.
+void SteamMultiplayerPeer::_expire_split_messages() {
+	int64_t now = SteamNetworkingUtils()->GetLocalTimestamp();
+	int64_t timeout = (int64_t)split_timeout * 1000;
+	LocalVector<uint64_t> expired;
+	for (const KeyValue<uint64_t, SplitMessage> &E : split_messages) {
+		if (now - E.value.started > timeout) {
+			expired.push_back(E.key);
+		}
+	}
+	for (uint32_t i = 0; i < expired.size(); i++) {
+		HashMap<uint64_t, SplitMessage>::Iterator E = split_messages.find(expired[i]);
+		incomplete_messages++;
+		if (deliver_partial_messages) {
+			const SplitMessage &split = E->value;
+			for (uint32_t part = 0; part < split.count; part++) {
+				if (!(split.received_mask[part >> 6] & (1ULL << (part & 63)))) {
+					memset(split.packet->data + part * split.part_size, 0, split.part_size);
+				}
+			}
+			split.packet->partial = true;
+			split.packet->received_at = now;
+			_deliver_packet(split.packet, split.sequence, split.sent);
+		}
+		split_messages.remove(E);
+	}
+}
+
+// The sender's clock is only used through differences, so the two clocks need not agree.
+// Transit above the baseline is queueing delay and is subtracted from the playout time.
+void SteamMultiplayerPeer::_jitter_push(const Ref<SteamPacketPeer> &p_packet, uint16_t p_sequence, uint32_t p_sent, int64_t p_received) {
+	JitterBuffer &buffer = jitter_buffers[p_packet->peer_id];
+	if (buffer.released && (int16_t)(p_sequence - buffer.last_released) <= 0) {
+		late_packets++;
+		return;
+	}
+
+	uint32_t transit = (uint32_t)p_received - p_sent;
+	if (!buffer.synced) {
+		buffer.synced = true;
+		buffer.offset = transit;
+		buffer.last_transit = transit;
+		buffer.playout_delay = (int64_t)jitter_min_delay * 1000;
+	}
+	int64_t d = ABS((int64_t)(int32_t)(transit - buffer.last_transit));
+	buffer.jitter += (d - buffer.jitter) / 16;
+	buffer.last_transit = transit;
+	// Follow a lower baseline at once, a higher one (route change) slowly.
+	int32_t drift = (int32_t)(transit - buffer.offset);
+	if (drift < 0) {
+		buffer.offset = transit;
+		drift = 0;
+	} else {
+		buffer.offset += drift / 64;
+	}
+
+	int64_t target = CLAMP((int64_t)jitter_min_delay * 1000 + 3 * buffer.jitter, (int64_t)jitter_min_delay * 1000, (int64_t)jitter_max_delay * 1000);
+	buffer.playout_delay += (target - buffer.playout_delay) / 8;
+
+	JitterEntry entry;
+	entry.packet = p_packet;
+	entry.sequence = p_sequence;
+	entry.release_at = p_received - (int32_t)(transit - buffer.offset) + buffer.playout_delay;
+
+	List<JitterEntry>::Element *E = buffer.pending.back();
+	while (E && (int16_t)(p_sequence - E->get().sequence) < 0) {
+		E = E->prev();
+	}
+	if (E && E->get().sequence == p_sequence) {
+		return; // duplicate
+	}
+	if (E) {
+		buffer.pending.insert_after(E, entry);
+	} else {
+		buffer.pending.push_front(entry);
+	}
+}
+
+void SteamMultiplayerPeer::_release_jitter_buffers() {
+	int64_t now = SteamNetworkingUtils()->GetLocalTimestamp();
+	for (KeyValue<int32_t, JitterBuffer> &E : jitter_buffers) {
+		JitterBuffer &buffer = E.value;
+		while (buffer.pending.size() > 0) {
+			const JitterEntry &entry = buffer.pending.front()->get();
+			if (entry.release_at > now && buffer.pending.size() <= JITTER_BUFFER_MAX_PACKETS) {
+				break;
+			}
+			incoming_packets.push_back(entry.packet);
+			buffer.released = true;
+			buffer.last_released = entry.sequence;
+			buffer.pending.pop_front();
+		}
+	}
+}
+
+// ZERO-COPY SENDS ///////////////////
+uint8_t *SteamMultiplayerPeer::begin_message(int32_t p_size, MultiplayerPeer::TransferMode p_mode, SteamNetworkingMessage_t **r_message) {
+	ERR_FAIL_NULL_V(r_message, nullptr);
+	*r_message = nullptr;
+	int flags = _get_steam_transfer_flag(p_mode);
+	int32_t relay_size = native_relay ? RELAY_HEADER_SIZE : 0;
+	int32_t header_size = _get_stream_header_size(flags);
+	int32_t split_size = _get_split_header_size(flags);
+	ERR_FAIL_COND_V_MSG(p_size < 0 || p_size + relay_size + header_size + split_size > MAX_STEAM_PACKET_SIZE, nullptr, "Invalid message size.");
+
+	SteamNetworkingMessage_t *msg = SteamNetworkingUtils()->AllocateMessage(p_size + relay_size + header_size + split_size);
+	ERR_FAIL_NULL_V_MSG(msg, nullptr, "Steam could not allocate a message.");
+	msg->m_nFlags = flags;
+	if (relay_size > 0) {
+		_write_relay_header((uint8_t *)msg->m_pData, 1); // clients fill in the destination on commit
+	}
+	if (header_size > 0) {
+		_write_stream_header((uint8_t *)msg->m_pData + relay_size, header_size);
+	}
+	if (split_size > 0) {
+		((uint8_t *)msg->m_pData)[relay_size + header_size] = 1; // never split, Steam fragments it
+	}
+	*r_message = msg;
+	return (uint8_t *)msg->m_pData + relay_size + header_size + split_size;
+}
+
+Error SteamMultiplayerPeer::commit_message(SteamNetworkingMessage_t *p_message, int32_t p_peer) {
+	ERR_FAIL_NULL_V(p_message, ERR_INVALID_PARAMETER);
+	if (!_is_active() || connection_status != CONNECTION_CONNECTED) {
+		p_message->Release();
+		ERR_FAIL_V_MSG(ERR_UNCONFIGURED, "The multiplayer instance isn't currently connected to any server or client.");
+	}
+	const uint8_t *data = (const uint8_t *)p_message->m_pData;
+	int32_t size = p_message->m_cbSize;
+	int flags = p_message->m_nFlags;
+
+	int32_t route_peer = p_peer;
+	if (native_relay && active_mode == MODE_CLIENT) {
+		// Mesh broadcasts are left to the host, only single peers take a direct link.
+		int32_t field = p_peer;
+		route_peer = mesh && p_peer > 1 ? _mesh_route(p_peer, field) : 1;
+		_write_relay_header((uint8_t *)p_message->m_pData, field);
+	}
+
+	if (route_peer <= 0) {
+		LocalVector<Ref<SteamConnection>> targets;
+		_collect_targets(route_peer, TARGET_GROUP_NONE, targets);
+		Error errorCode = _multicast(data, size, flags, targets);
+		p_message->Release();
+		return errorCode;
+	}
+
+	HashMap<int32_t, uint32_t>::ConstIterator E = slot_by_peer_id.find(route_peer);
+	if (!E) {
+		p_message->Release();
+		ERR_FAIL_V_MSG(ERR_INVALID_PARAMETER, vformat("Invalid target peer: %d", p_peer));
+	}
+	const Ref<SteamConnection> &connection = connection_slots[E->value].connection;
+	bool reliable = flags & k_nSteamNetworkingSend_Reliable;
+	if (connection->pending_retry_packets.size() > 0 || connection->is_parked() || connection->max_pending_bytes > 0 || (reliable && !_has_send_buffer_room(connection, size))) {
+		// The scheduler owns its packets, and a reliable send Steam would refuse has to stay
+		// queued for retry. Fall back to a copy.
+		Error errorCode = connection->send(_make_packet(data, size, flags));
+		p_message->Release();
+		return errorCode;
+	}
+
+	p_message->m_conn = connection->steam_connection;
+	int64 result = 0;
+	int64_t started = 0;
+	if (collect_histograms) {
+		started = SteamNetworkingUtils()->GetLocalTimestamp();
+		_get_channel_histograms(p_peer, _get_stream_header_size(flags) > 0 ? send_stream : 0).sent_size.record(size);
+	}
+	SteamNetworkingSockets()->SendMessages(1, &p_message, &result);
+	if (collect_histograms && result >= 0) {
+		connection->send_latency[_get_stream_header_size(flags) > 0 ? send_stream : 0].record(SteamNetworkingUtils()->GetLocalTimestamp() - started);
+	}
+	// Steam released the message either way. Reliable ones were checked against the send buffer.
+	ERR_FAIL_COND_V_MSG(result < 0, FAILED, vformat("Message send error: %d", -result));
+	return OK;
+}
+
+// Whether Steam's send buffer for the connection takes p_size more bytes, which is what
+// SendMessages refuses reliable messages over.
+bool SteamMultiplayerPeer::_has_send_buffer_room(const Ref<SteamConnection> &p_connection, int32_t p_size) const {
+	int32_t buffer_size = 0;
+	size_t value_size = sizeof(buffer_size);
+	ESteamNetworkingConfigDataType type;
+	if (SteamNetworkingUtils()->GetConfigValue(k_ESteamNetworkingConfig_SendBufferSize, k_ESteamNetworkingConfig_Connection, p_connection->steam_connection, &type, &buffer_size, &value_size) < k_ESteamNetworkingGetConfigValue_OK) {
+		return false;
+	}
+	SteamNetConnectionRealTimeStatus_t status;
+	if (SteamNetworkingSockets()->GetConnectionRealTimeStatus(p_connection->steam_connection, &status, 0, nullptr) != k_EResultOK) {
+		return false;
+	}
+	return (int64_t)status.m_cbPendingReliable + status.m_cbPendingUnreliable + p_size <= buffer_size;
+}
+
+void SteamMultiplayerPeer::discard_message(SteamNetworkingMessage_t *p_message) {
+	ERR_FAIL_NULL(p_message);
+	p_message->Release();
+}
+
+// MEMORY ACCOUNTING ///////////////////
+enum MemoryStat {
+	MEMORY_STAT_LIVE_PACKET_PEERS,
+	MEMORY_STAT_LIVE_MULTIPLEX_PACKETS,
+	MEMORY_STAT_LIVE_CONNECTIONS,
+	MEMORY_STAT_ALLOCATIONS_PER_POLL,
+	MEMORY_STAT_INCOMING_PACKETS,
+	MEMORY_STAT_INCOMING_BYTES,
+	MEMORY_STAT_JITTER_BUFFERED_PACKETS,
+	MEMORY_STAT_PENDING_PACKETS,
+	MEMORY_STAT_PENDING_BYTES,
+	MEMORY_STAT_PACKET_RESERVED_BYTES,
+	MEMORY_STAT_MULTIPLEX_QUEUE_BYTES,
+	MEMORY_STAT_MAX,
+};
+
+static const char *memory_stat_names[MEMORY_STAT_MAX] = {
+	"live_packet_peers",
+	"live_multiplex_packets",
+	"live_connections",
+	"allocations_per_poll",
+	"incoming_packets",
+	"incoming_bytes",
+	"jitter_buffered_packets",
+	"pending_packets",
+	"pending_bytes",
+	"packet_reserved_bytes",
+	"multiplex_queue_bytes",
+};
+
+// Packet counts are O(1), byte totals walk the queues only when r_bytes is set.
+int64_t SteamMultiplayerPeer::_get_jitter_buffered(int64_t *r_bytes) const {
+	int64_t packets = 0;
+	for (const KeyValue<int32_t, JitterBuffer> &E : jitter_buffers) {
+		packets += E.value.pending.size();
+		if (r_bytes) {
+			for (const List<JitterEntry>::Element *J = E.value.pending.front(); J; J = J->next()) {
+				*r_bytes += J->get().packet->size;
+			}
+		}
+	}
+	return packets;
+}
+
+int64_t SteamMultiplayerPeer::_get_pending(int64_t *r_bytes) const {
+	int64_t packets = 0;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_null()) {
+			continue;
+		}
+		packets += connection->pending_retry_packets.size();
+		if (r_bytes) {
+			for (const List<Ref<SteamPacketPeer>>::Element *E = connection->pending_retry_packets.front(); E; E = E->next()) {
+				*r_bytes += E->get()->size;
+			}
+		}
+	}
+	return packets;
+}
+
+// Live object counts are process wide, queue figures cover this peer only. *_bytes count
+// payloads; packet_reserved_bytes is what queued SteamPacketPeers actually occupy, each
+// reserves a full MAX_STEAM_PACKET_SIZE buffer.
+int64_t SteamMultiplayerPeer::_get_memory_stat(int p_stat) const {
+	switch (p_stat) {
+		case MEMORY_STAT_LIVE_PACKET_PEERS:
+			return SteamMemoryStats::live_packet_peers.load(std::memory_order_relaxed);
+		case MEMORY_STAT_LIVE_MULTIPLEX_PACKETS:
+			return SteamMemoryStats::live_multiplex_packets.load(std::memory_order_relaxed);
+		case MEMORY_STAT_LIVE_CONNECTIONS:
+			return SteamMemoryStats::live_connections.load(std::memory_order_relaxed);
+		case MEMORY_STAT_ALLOCATIONS_PER_POLL:
+			return allocations_last_poll;
+		case MEMORY_STAT_INCOMING_PACKETS:
+			return incoming_packets.size();
+		case MEMORY_STAT_INCOMING_BYTES: {
+			int64_t bytes = 0;
+			for (const List<Ref<SteamPacketPeer>>::Element *E = incoming_packets.front(); E; E = E->next()) {
+				bytes += E->get()->size;
+			}
+			_get_jitter_buffered(&bytes);
+			return bytes;
+		}
+		case MEMORY_STAT_JITTER_BUFFERED_PACKETS:
+			return _get_jitter_buffered(nullptr);
+		case MEMORY_STAT_PENDING_PACKETS:
+			return _get_pending(nullptr);
+		case MEMORY_STAT_PENDING_BYTES: {
+			int64_t bytes = 0;
+			_get_pending(&bytes);
+			return bytes;
+		}
+		case MEMORY_STAT_PACKET_RESERVED_BYTES:
+			return (int64_t)(incoming_packets.size() + _get_jitter_buffered(nullptr) + _get_pending(nullptr)) * (int64_t)sizeof(SteamPacketPeer);
+		case MEMORY_STAT_MULTIPLEX_QUEUE_BYTES:
+			return SteamMemoryStats::multiplex_queue_bytes.load(std::memory_order_relaxed);
+	}
+	ERR_FAIL_V(0);
+}
+
+Dictionary SteamMultiplayerPeer::get_memory_stats() const {
+	Dictionary stats;
+	for (int i = 0; i < MEMORY_STAT_MAX; i++) {
+		stats[memory_stat_names[i]] = _get_memory_stat(i);
+	}
+	return stats;
+}
+
+Variant SteamMultiplayerPeer::get_memory_stat(const String &name) const {
+	for (int i = 0; i < MEMORY_STAT_MAX; i++) {
+		if (name == memory_stat_names[i]) {
+			return _get_memory_stat(i);
+		}
+	}
+	return Variant();
+}
+
+// Registers every memory stat as a custom monitor under SteamMultiplayerPeer/, so they show
+// up in the debugger's monitor tab. Only one peer at a time can own the monitors.
+void SteamMultiplayerPeer::add_performance_monitors() {
+	ERR_FAIL_COND_MSG(performance_monitors, "Performance monitors are already registered.");
+	Performance *performance = Performance::get_singleton();
+	for (const char *name : memory_stat_names) {
+		StringName id = String("SteamMultiplayerPeer/") + name;
+		ERR_FAIL_COND_MSG(performance->has_custom_monitor(id), vformat("Monitor %s is already registered by another peer.", id));
+	}
+	for (const char *name : memory_stat_names) {
+		performance->add_custom_monitor(String("SteamMultiplayerPeer/") + name, Callable(this, "get_memory_stat").bind(String(name)));
+	}
+	performance_monitors = true;
+}
+
+void SteamMultiplayerPeer::remove_performance_monitors() {
+	ERR_FAIL_COND_MSG(!performance_monitors, "Performance monitors are not registered.");
+	Performance *performance = Performance::get_singleton();
+	for (const char *name : memory_stat_names) {
+		StringName id = String("SteamMultiplayerPeer/") + name;
+		if (performance->has_custom_monitor(id)) {
+			performance->remove_custom_monitor(id);
+		}
+	}
+	performance_monitors = false;
+}
+
+// HISTOGRAMS ///////////////////
+void SteamMultiplayerPeer::set_collect_histograms(const bool new_collect_histograms) {
+	collect_histograms = new_collect_histograms;
+}
+
+bool SteamMultiplayerPeer::get_collect_histograms() const {
+	return collect_histograms;
+}
+
+// { "poll_drain": histogram, "peers": { peer_id: { channel: { "sent_size", "received_size",
+// "send_latency_usec", "consume_delay_usec" } } } }, see SteamHistogram::to_dictionary.
+Dictionary SteamMultiplayerPeer::get_histograms() const {
+	Dictionary peers;
+	for (const KeyValue<uint64_t, ChannelHistograms> &E : channel_histograms) {
+		int32_t peer_id = (int32_t)(uint32_t)(E.key >> 16);
+		if (!peers.has(peer_id)) {
+			peers[peer_id] = Dictionary();
+		}
+		Dictionary channels = peers[peer_id];
+		Dictionary channel;
+		channel["sent_size"] = E.value.sent_size.to_dictionary();
+		channel["received_size"] = E.value.received_size.to_dictionary();
+		channel["consume_delay_usec"] = E.value.consume_delay.to_dictionary();
+		channels[(int32_t)(E.key & 0xFFFF)] = channel;
+	}
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_null() || connection->peer_id == -1) {
+			continue;
+		}
+		for (const KeyValue<uint16_t, SteamHistogram> &E : connection->send_latency) {
+			if (!peers.has(connection->peer_id)) {
+				peers[connection->peer_id] = Dictionary();
+			}
+			Dictionary channels = peers[connection->peer_id];
+			if (!channels.has(E.key)) {
+				channels[E.key] = Dictionary();
+			}
+			Dictionary channel = channels[E.key];
+			channel["send_latency_usec"] = E.value.to_dictionary();
+		}
+	}
+
+	Dictionary result;
+	result["poll_drain"] = poll_drain.to_dictionary();
+	result["peers"] = peers;
+	return result;
+}
+
+void SteamMultiplayerPeer::reset_histograms() {
+	channel_histograms.clear();
+	poll_drain.reset();
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		if (connection_slots[i].connection.is_valid()) {
+			connection_slots[i].connection->send_latency.clear();
+		}
+	}
+}
+
+Error SteamMultiplayerPeer::dump_network_trace(const String &path) {
+	return steam_trace_dump(path);
+}
+
+Ref<SteamPacketPeer> SteamMultiplayerPeer::take_packet() {
+	if (incoming_packets.size() == 0) {
+		return Ref<SteamPacketPeer>();
+	}
+	return _pop_incoming_packet();
+}
+
+// NATIVE RELAY ///////////////////
+void SteamMultiplayerPeer::set_native_relay(const bool new_native_relay) {
+	ERR_FAIL_COND_MSG(_is_active(), "The native relay changes the wire format, set it before connecting.");
+	native_relay = new_native_relay;
+}
+
+bool SteamMultiplayerPeer::get_native_relay() const {
+	return native_relay;
+}
+
+uint64_t SteamMultiplayerPeer::get_relayed_packet_count() const {
+	return relayed_packets;
+}
+
+void SteamMultiplayerPeer::_write_relay_header(uint8_t *w, int32_t p_peer) {
+	for (int i = 0; i < RELAY_HEADER_SIZE; i++) {
+		w[i] = ((uint32_t)p_peer >> (8 * i)) & 0xFF;
+	}
+}
+
+// MESH ///////////////////
+// Hosts with a host_steam_id of 0 or our own, joins that host otherwise. Turns native_relay on.
+// Clients also listen on n_virtual_port for direct links from the other clients.
+Error SteamMultiplayerPeer::create_mesh(uint64_t host_steam_id, int n_virtual_port) {
+	ERR_FAIL_COND_V_MSG(_is_active(), ERR_ALREADY_IN_USE, "The multiplayer instance is already active.");
+	native_relay = true;
+	bool host = host_steam_id == 0 || host_steam_id == _local_steam_id();
+	Error err = host ? create_host(n_virtual_port) : create_client(host_steam_id, n_virtual_port);
+	if (err != OK) {
+		return err;
+	}
+	if (!host) {
+		listen_socket = SteamNetworkingSockets()->CreateListenSocketP2P(n_virtual_port, _get_connection_option_count(), _get_connection_options());
+		if (listen_socket == k_HSteamListenSocket_Invalid) {
+			WARN_PRINT(String("Failed to open the mesh listen socket, other peers are reached through the host."));
+		} else {
+			SteamNetworkingHub::get_singleton()->claim_listen_socket(listen_socket, this);
+		}
+	}
+	mesh = true;
+	mesh_virtual_port = n_virtual_port;
+	return OK;
+}
+
+bool SteamMultiplayerPeer::is_mesh() const {
+	return mesh;
+}
+
+bool SteamMultiplayerPeer::has_mesh_link(int32_t peer_id) const {
+	return mesh && active_mode == MODE_CLIENT && peer_id != 1 && slot_by_peer_id.has(peer_id);
+}
+
+// Host side. Body is a control byte followed by little endian Steam IDs.
+void SteamMultiplayerPeer::_send_mesh_control(const Ref<SteamConnection> &p_to, MeshControl p_type, const LocalVector<uint64_t> &p_steam_ids) {
+	LocalVector<uint8_t> buffer;
+	buffer.resize(RELAY_HEADER_SIZE + 1 + p_steam_ids.size() * 8);
+	uint8_t *w = buffer.ptr();
+	_write_relay_header(w, 0);
+	w[RELAY_HEADER_SIZE] = p_type;
+	w += RELAY_HEADER_SIZE + 1;
+	for (uint32_t i = 0; i < p_steam_ids.size(); i++) {
+		for (int j = 0; j < 8; j++) {
+			*w++ = (p_steam_ids[i] >> (8 * j)) & 0xFF;
+		}
+	}
+	p_to->send(_make_packet(buffer.ptr(), buffer.size(), k_nSteamNetworkingSend_Reliable, true));
+}
+
+// Tells the new client about everyone else and everyone else about the new client.
+void SteamMultiplayerPeer::_mesh_peer_joined(const Ref<SteamConnection> &p_peer) {
+	LocalVector<uint64_t> joined;
+	joined.push_back(p_peer->steam_id);
+	LocalVector<uint64_t> others;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && connection != p_peer && connection->peer_id != -1) {
+			others.push_back(connection->steam_id);
+			_send_mesh_control(connection, MESH_PEERS_ADDED, joined);
+		}
+	}
+	if (others.size() > 0) {
+		_send_mesh_control(p_peer, MESH_PEERS_ADDED, others);
+	}
+}
+
+void SteamMultiplayerPeer::_mesh_peer_left(uint64_t p_steam_id) {
+	LocalVector<uint64_t> left;
+	left.push_back(p_steam_id);
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && connection->peer_id != -1) {
+			_send_mesh_control(connection, MESH_PEERS_REMOVED, left);
+		}
+	}
+}
+
+// Client side. Announced peers are connected right away since the host relay reaches them,
+// the direct link is an upgrade that comes and goes without peer signals.
+void SteamMultiplayerPeer::_handle_mesh_control(const uint8_t *p_data, uint32_t p_size) {
+	ERR_FAIL_COND_MSG(p_size < 1 || (p_size - 1) % 8 != 0, "Malformed mesh announcement.");
+	uint8_t type = p_data[0];
+	uint64_t local_steam_id = _local_steam_id();
+	for (uint32_t offset = 1; offset < p_size && _is_active(); offset += 8) {
+		uint64_t steam_id = 0;
+		for (int j = 0; j < 8; j++) {
+			steam_id |= (uint64_t)p_data[offset + j] << (8 * j);
+		}
+		if (steam_id == local_steam_id || steam_id == remote_steam_id) {
+			continue;
+		}
+		int32_t peer_id = _derive_peer_id(steam_id);
+		if (type == MESH_PEERS_ADDED) {
+			if (mesh_peers.has(peer_id)) {
+				continue;
+			}
+			mesh_peers[peer_id] = steam_id;
+			if (local_steam_id < steam_id) {
+				SteamNetworkingIdentity identity;
+				identity.SetSteamID64(steam_id);
+				HSteamNetConnection link = SteamNetworkingSockets()->ConnectP2P(identity, mesh_virtual_port, _get_connection_option_count(), _get_connection_options());
+				if (link == k_HSteamNetConnection_Invalid) {
+					WARN_PRINT(vformat("Failed to dial mesh peer %d, using the host relay.", peer_id));
+				} else {
+					SteamNetworkingHub::get_singleton()->claim_connection(link, this);
+				}
+			}
+			emit_signal("peer_connected", peer_id);
+		} else if (type == MESH_PEERS_REMOVED) {
+			if (!mesh_peers.erase(peer_id)) {
+				continue;
+			}
+			HashMap<uint64_t, uint32_t>::ConstIterator E = slot_by_steam_id.find(steam_id);
+			if (E) {
+				uint32_t slot = E->value;
+				connection_slots[slot].connection->close();
+				_remove_connection(slot);
+			}
+			emit_signal("peer_disconnected", peer_id);
+		} else {
+			ERR_FAIL_MSG(vformat("Unknown mesh announcement %d.", type));
+		}
+	}
+}
+
+// Only links from peers the host announced are accepted, anything else would bypass it.
+void SteamMultiplayerPeer::_accept_mesh_link(uint64_t p_steam_id, HSteamNetConnection p_connection, uint32_t p_slot) {
+	int32_t peer_id = _derive_peer_id(p_steam_id);
+	if (!mesh_peers.has(peer_id) || slot_by_peer_id.has(peer_id)) {
+		_close_connection_handle(p_connection, k_ESteamNetConnectionEnd_AppException_Generic, "Not an announced mesh peer");
+		connection_slots[p_slot].connection->steam_connection = k_HSteamNetConnection_Invalid;
+		_remove_connection(p_slot);
+		return;
+	}
+	set_steam_id_peer(p_steam_id, peer_id);
+	emit_signal("mesh_link_changed", peer_id, true);
+}
+
+// A lost or refused link is dropped without parking, packets for that peer go back to the host.
+void SteamMultiplayerPeer::_close_mesh_link(const SteamNetConnectionStatusChangedCallback_t *call_data, int64_t p_slot) {
+	_close_connection_handle(call_data->m_hConn, k_ESteamNetConnectionEnd_App_Generic, "Mesh link closed");
+	if (p_slot == -1) {
+		return; // a dial that never connected
+	}
+	int32_t peer_id = connection_slots[p_slot].connection->peer_id;
+	connection_slots[p_slot].connection->steam_connection = k_HSteamNetConnection_Invalid;
+	_remove_connection(p_slot);
+	if (peer_id != -1 && mesh_peers.has(peer_id)) {
+		emit_signal("mesh_link_changed", peer_id, false);
+	}
+}
+
+// Returns the peer to send through: p_peer itself over a live direct link, else the host.
+// r_field is the relay field to write, our own id for a direct link or p_peer for the host.
+int32_t SteamMultiplayerPeer::_mesh_route(int32_t p_peer, int32_t &r_field) const {
+	if (p_peer != 1) {
+		HashMap<int32_t, uint32_t>::ConstIterator E = slot_by_peer_id.find(p_peer);
+		if (E && !connection_slots[E->value].connection->is_parked()) {
+			r_field = unique_id;
+			return p_peer;
+		}
+	}
+	r_field = p_peer;
+	return 1;
+}
+
+// Client side _put_packet. Broadcasts become one send per peer so each can take its own route.
+Error SteamMultiplayerPeer::_mesh_put(uint8_t *w, int32_t p_size, int p_flags, uint16_t p_channel) {
+	LocalVector<int32_t> destinations;
+	if (target_peer > 0) {
+		destinations.push_back(target_peer);
+	} else {
+		int32_t excluded_peer = -target_peer;
+		if (excluded_peer != 1) {
+			destinations.push_back(1);
+		}
+		for (const KeyValue<int32_t, uint64_t> &E : mesh_peers) {
+			if (E.key != excluded_peer) {
+				destinations.push_back(E.key);
+			}
+		}
+	}
+
+	Error returnValue = OK;
+	for (uint32_t i = 0; i < destinations.size(); i++) {
+		int32_t field = 0;
+		Ref<SteamConnection> route = get_connection_by_peer(_mesh_route(destinations[i], field));
+		_write_relay_header(w, field);
+		if (collect_histograms) {
+			_get_channel_histograms(destinations[i], p_channel).sent_size.record(p_size);
+		}
+		Error errorCode = route->send(_make_packet(w, p_size, p_flags));
+		if (errorCode != OK) {
+			returnValue = errorCode;
+		}
+	}
+	return returnValue;
+}
+
+// Host side. The destination in the header is replaced by the sender's peer id, so clients
+// can't spoof the source. A message for a single peer is sent on as is, without a copy.
+SteamMultiplayerPeer::RelayResult SteamMultiplayerPeer::_relay_message(SteamNetworkingMessage_t *p_msg, const Ref<SteamConnection> &p_sender) {
+	if (p_msg->GetSize() < RELAY_HEADER_SIZE) {
+		return RELAY_DELIVER; // rejected by _process_message
+	}
+	uint8_t *data = (uint8_t *)p_msg->m_pData;
+	int32_t size = p_msg->GetSize();
+	int32_t destination = (int32_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+	if (destination == 1) {
+		return RELAY_DELIVER;
+	}
+	_write_relay_header(data, p_sender->peer_id);
+	int flags = p_msg->m_nFlags & k_nSteamNetworkingSend_Reliable;
+	relayed_packets++;
+
+	if (destination > 1) {
+		HashMap<int32_t, uint32_t>::ConstIterator E = slot_by_peer_id.find(destination);
+		if (!E) {
+			WARN_PRINT(vformat("Dropping relayed packet for unknown peer %d.", destination));
+			return RELAY_FORWARDED;
+		}
+		const Ref<SteamConnection> &target = connection_slots[E->value].connection;
+		if (target->pending_retry_packets.size() > 0 || target->is_parked() || target->max_pending_bytes > 0) {
+			target->send(_make_packet(data, size, flags, true));
+			return RELAY_FORWARDED;
+		}
+		p_msg->m_conn = target->steam_connection;
+		p_msg->m_nFlags = flags;
+		p_msg->m_idxLane = 0;
+		int64 result = 0;
+		SteamNetworkingSockets()->SendMessages(1, &p_msg, &result);
+		if (result < 0) {
+			WARN_PRINT(vformat("Relay send error: %d", -result));
+		}
+		return RELAY_CONSUMED;
+	}
+
+	// 0 reaches every peer, -id every peer but that one. Never echoed back to the sender.
+	int32_t excluded_peer = -destination;
+	LocalVector<Ref<SteamConnection>> targets;
+	for (uint32_t i = 0; i < connection_slots.size(); i++) {
+		const Ref<SteamConnection> &connection = connection_slots[i].connection;
+		if (connection.is_valid() && connection->peer_id != -1 && connection->peer_id != p_sender->peer_id && connection->peer_id != excluded_peer) {
+			targets.push_back(connection);
+		}
+	}
+	_multicast(data, size, flags, targets, true);
+	return excluded_peer == 1 ? RELAY_FORWARDED : RELAY_DELIVER;
+}
+
+// BATCHES ///////////////////
+// Records are BATCH_RECORD_SIZE ints per packet: offset, length, peer, channel, transfer mode,
+// with offset and length indexing the shared payload array. The channel is the coalescing stream.
+
+// Returns [PackedByteArray payloads, PackedInt32Array records] for up to max queued packets.
+Array SteamMultiplayerPeer::get_packets_batch(int32_t max) {
+	Array result;
+	PackedByteArray payloads;
+	PackedInt32Array records;
+	ERR_FAIL_COND_V(max < 0, result);
+
+	int32_t count = MIN(max, (int32_t)incoming_packets.size());
+	int64_t total = 0;
+	const List<Ref<SteamPacketPeer>>::Element *E = incoming_packets.front();
+	for (int32_t i = 0; i < count; i++, E = E->next()) {
+		total += E->get()->size;
+	}
+	payloads.resize(total);
+	records.resize(count * BATCH_RECORD_SIZE);
+
+	uint8_t *w = payloads.ptrw();
+	int32_t *r = records.ptrw();
+	int64_t offset = 0;
+	for (int32_t i = 0; i < count; i++) {
+		const Ref<SteamPacketPeer> &packet = _pop_incoming_packet();
+		memcpy(w + offset, packet->data, packet->size);
+		r[0] = offset;
+		r[1] = packet->size;
+		r[2] = packet->peer_id;
+		r[3] = packet->channel;
+		r[4] = (packet->transfer_mode & k_nSteamNetworkingSend_Reliable) ? TRANSFER_MODE_RELIABLE : TRANSFER_MODE_UNRELIABLE;
+		r += BATCH_RECORD_SIZE;
+		offset += packet->size;
+	}
+
+	result.push_back(payloads);
+	result.push_back(records);
+	return result;
+}
+
+// Sends each record as if by set_target_peer, set_transfer_mode and put_packet. The peer
+// field follows set_target_peer (0 broadcasts, -id excludes a peer), the channel is ignored.
+Error SteamMultiplayerPeer::put_packets_batch(const PackedByteArray &payloads, const PackedInt32Array &records) {
+	ERR_FAIL_COND_V_MSG(records.size() % BATCH_RECORD_SIZE != 0, ERR_INVALID_PARAMETER, "Batch records must hold five ints per packet.");
+
+	int32_t saved_target_peer = target_peer;
+	int32_t saved_target_group = target_group;
+	MultiplayerPeer::TransferMode saved_transfer_mode = transfer_mode;
+	target_group = TARGET_GROUP_NONE;
+
+	Error returnValue = OK;
+	const uint8_t *data = payloads.ptr();
+	const int32_t *r = records.ptr();
+	for (int64_t i = 0; i < records.size(); i += BATCH_RECORD_SIZE, r += BATCH_RECORD_SIZE) {
+		if (r[0] < 0 || r[1] < 0 || (int64_t)r[0] + r[1] > payloads.size()) {
+			ERR_PRINT(vformat("Batch record %d is out of the payload bounds.", i / BATCH_RECORD_SIZE));
+			returnValue = ERR_INVALID_PARAMETER;
+			continue;
+		}
+		if (r[4] < TRANSFER_MODE_UNRELIABLE || r[4] > TRANSFER_MODE_RELIABLE) {
+			ERR_PRINT(vformat("Batch record %d has an unknown transfer mode %d.", i / BATCH_RECORD_SIZE, r[4]));
+			returnValue = ERR_INVALID_PARAMETER;
+			continue;
+		}
+		target_peer = r[2];
+		transfer_mode = (MultiplayerPeer::TransferMode)r[4];
+		Error errorCode = _put_packet(data + r[0], r[1]);
+		if (errorCode != OK) {
+			returnValue = errorCode;
+		}
+	}
+
+	target_peer = saved_target_peer;
+	target_group = saved_target_group;
+	transfer_mode = saved_transfer_mode;
+	return returnValue;
+}
+
+// FAST RECONNECT ///////////////////
+#define RECONNECT_RETRY_INTERVAL_USEC 500000
+// Sent when parking, so a remote that still hears the close parks as well.
+#define RECONNECT_PARK_END_REASON (k_ESteamNetConnectionEnd_AppException_Min + 100)
+
+// Only unexpected losses are parked. Closes initiated by the remote application
+// (App_* and AppException_* end reasons) are real disconnects, unless the remote parked.
+bool SteamMultiplayerPeer::_should_park(const SteamNetConnectionStatusChangedCallback_t *call_data, uint32_t p_slot) const {
+	if (reconnect_grace_time <= 0 || connection_slots[p_slot].connection->peer_id == -1) {
+		return false;
+	}
+	if (call_data->m_info.m_eState == k_ESteamNetworkingConnectionState_ProblemDetectedLocally) {
+		return true;
+	}
+	int end_reason = call_data->m_info.m_eEndReason;
+	return end_reason == RECONNECT_PARK_END_REASON || end_reason < k_ESteamNetConnectionEnd_App_Min || end_reason > k_ESteamNetConnectionEnd_AppException_Max;
+}
+
+void SteamMultiplayerPeer::_park_connection(uint32_t p_slot) {
+	Ref<SteamConnection> parked = connection_slots[p_slot].connection;
+	_close_connection_handle(parked->steam_connection, RECONNECT_PARK_END_REASON, "Parked for reconnect");
+	parked->steam_connection = k_HSteamNetConnection_Invalid;
+	parked->parked_since = Time::get_singleton()->get_ticks_usec();
+
+	parked->drop_unreliable_pending();
+
+	slot_by_steam_id.erase(parked->steam_id);
+	parked_slots[parked->steam_id] = p_slot;
+}
+
+// Moves the handle of a fresh connection into the parked one and frees the
+// fresh slot. Messages still stamped with the fresh slot fall back to the Steam ID lookup.
+Ref<SteamConnection> SteamMultiplayerPeer::_resume_parked(uint32_t p_parked_slot, uint32_t p_fresh_slot) {
+	Ref<SteamConnection> parked = connection_slots[p_parked_slot].connection;
+	Ref<SteamConnection> fresh = connection_slots[p_fresh_slot].connection;
+
+	parked->steam_connection = fresh->steam_connection;
+	parked->parked_since = 0;
+	fresh->steam_connection = k_HSteamNetConnection_Invalid;
+	_remove_connection(p_fresh_slot);
+
+	parked_slots.erase(parked->steam_id);
+	slot_by_steam_id[parked->steam_id] = p_parked_slot;
+	SteamNetworkingSockets()->SetConnectionUserData(parked->steam_connection, _make_slot_user_data(p_parked_slot, connection_slots[p_parked_slot].generation));
+	return parked;
+}
+
+void SteamMultiplayerPeer::_expire_parked(uint64_t p_steam_id) {
+	HashMap<uint64_t, uint32_t>::Iterator P = parked_slots.find(p_steam_id);
+	ERR_FAIL_COND(!P);
+	uint32_t slot = P->value;
+	int peer_id = connection_slots[slot].connection->peer_id;
+	parked_slots.remove(P);
+	_remove_connection(slot);
+	if (mesh && _is_server()) {
+		_mesh_peer_left(p_steam_id);
+	}
+
+	emit_signal("peer_disconnected", peer_id);
+	if (!_is_server()) {
+		close();
+	}
+}
+
+void SteamMultiplayerPeer::_update_parked_connections() {
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	uint64_t grace = (uint64_t)reconnect_grace_time * 1000;
+
+	LocalVector<uint64_t> expired;
+	for (const KeyValue<uint64_t, uint32_t> &E : parked_slots) {
+		if (now - connection_slots[E.value].connection->parked_since > grace) {
+			expired.push_back(E.key);
+		}
+	}
+	for (uint32_t i = 0; i < expired.size() && _is_active(); i++) {
+		_expire_parked(expired[i]);
+	}
+
+	// Clients redial the host; servers wait for the client to come back.
+	if (_is_active() && !_is_server() && parked_slots.size() > 0 && connection == k_HSteamNetConnection_Invalid && now - last_reconnect_attempt > RECONNECT_RETRY_INTERVAL_USEC) {
+		last_reconnect_attempt = now;
+		if (ip_transport) {
+			connection = SteamNetworkingSockets()->ConnectByIPAddress(remote_ip_address, _get_connection_option_count(), _get_connection_options());
+		} else {
+			SteamNetworkingIdentity p_remote_id;
+			p_remote_id.SetSteamID64(remote_steam_id);
+			connection = SteamNetworkingSockets()->ConnectP2P(p_remote_id, remote_virtual_port, _get_connection_option_count(), _get_connection_options());
+		}
+		if (connection != k_HSteamNetConnection_Invalid) {
+			SteamNetworkingHub::get_singleton()->claim_connection(connection, this);
+		}
+	}
+}
+
+void SteamMultiplayerPeer::set_reconnect_grace_time(const int32_t new_grace_time) {
+	ERR_FAIL_COND_MSG(new_grace_time < 0, "The reconnect grace time can't be negative.");
+	reconnect_grace_time = new_grace_time;
+}
+
+int32_t SteamMultiplayerPeer::get_reconnect_grace_time() const {
+	return reconnect_grace_time;
+}
+
+// ADMISSION CONTROL ///////////////////
+void SteamMultiplayerPeer::set_max_clients(const int32_t new_max_clients) {
+	ERR_FAIL_COND_MSG(new_max_clients < 0, "The client limit can't be negative.");
+	max_clients = new_max_clients;
+}
+
+int32_t SteamMultiplayerPeer::get_max_clients() const {
+	return max_clients;
+}
+
+void SteamMultiplayerPeer::set_accept_rate(const int32_t new_accept_rate) {
+	ERR_FAIL_COND_MSG(new_accept_rate < 0, "The accept rate can't be negative.");
+	accept_rate = new_accept_rate;
+}
+
+int32_t SteamMultiplayerPeer::get_accept_rate() const {
+	return accept_rate;
+}
+
+void SteamMultiplayerPeer::set_accept_burst(const int32_t new_accept_burst) {
+	ERR_FAIL_COND_MSG(new_accept_burst < 1, "The accept burst must be at least 1.");
+	accept_burst = new_accept_burst;
+}
+
+int32_t SteamMultiplayerPeer::get_accept_burst() const {
+	return accept_burst;
+}
+
+void SteamMultiplayerPeer::set_max_pending_accepts(const int32_t new_max_pending) {
+	ERR_FAIL_COND_MSG(new_max_pending < 0, "The pending accept limit can't be negative.");
+	max_pending_accepts = new_max_pending;
+}
+
+int32_t SteamMultiplayerPeer::get_max_pending_accepts() const {
+	return max_pending_accepts;
+}
+
+int32_t SteamMultiplayerPeer::get_pending_accept_count() const {
+	return pending_accepts.size();
+}
+
+uint64_t SteamMultiplayerPeer::get_rejected_connection_count() const {
+	return rejected_connections;
+}
+
+// Hosts only. Mesh clients accept announced peers unthrottled and refuse everyone else,
+// a link the host never announced would bypass it. See also _accept_mesh_link.
+void SteamMultiplayerPeer::_admit_connection(HSteamNetConnection p_connection, uint64_t p_steam_id) {
+	if (!_is_server()) {
+		HashMap<int32_t, uint64_t>::ConstIterator E = mesh_peers.find(_derive_peer_id(p_steam_id));
+		if (!mesh || !E || E->value != p_steam_id) {
+			_reject_connection(p_connection, ADMISSION_REJECT_REFUSING);
+			return;
+		}
+		_accept_connection(p_connection);
+		return;
+	}
+	int reason = _get_admission_reject(p_steam_id);
+	if (reason != 0) {
+		_reject_connection(p_connection, reason);
+		return;
+	}
+	if (pending_accepts.size() > 0 || !_take_accept_token()) {
+		if (pending_accepts.size() >= max_pending_accepts) {
+			_reject_connection(p_connection, ADMISSION_REJECT_BUSY);
+			return;
+		}
+		pending_accepts.push_back(p_connection);
+		return;
+	}
+	_accept_connection(p_connection);
+}
+
+void SteamMultiplayerPeer::_accept_connection(HSteamNetConnection p_connection) {
+	EResult res = SteamNetworkingSockets()->AcceptConnection(p_connection);
+	if (res != k_EResultOK) {
+		SteamNetworkingSockets()->CloseConnection(p_connection, k_ESteamNetConnectionEnd_AppException_Generic, "Failed to accept connection", false);
+		return;
+	}
+	accepting.insert(p_connection);
+	SteamNetworkingHub::get_singleton()->claim_connection(p_connection, this);
+}
+
+void SteamMultiplayerPeer::_reject_connection(HSteamNetConnection p_connection, int p_reason) {
+	rejected_connections++;
+	SteamNetworkingSockets()->CloseConnection(p_connection, p_reason, "Rejected by admission control", false);
+}
+
+// 0 to admit. A Steam ID with a parked slot is resuming into it. Parked slots are held for
+// their owners, so they count toward max_clients like live ones.
+int SteamMultiplayerPeer::_get_admission_reject(uint64_t p_steam_id) const {
+	if (parked_slots.has(p_steam_id)) {
+		return 0;
+	}
+	if (_is_address_key(p_steam_id) && parked_slots.size() > 0) {
+		return 0; // may be resuming, checked again once its session token arrives
+	}
+	if (refuse_new_connections) {
+		return ADMISSION_REJECT_REFUSING;
+	}
+	if (max_clients > 0 && (int32_t)(slot_by_steam_id.size() + parked_slots.size() + accepting.size()) >= max_clients) {
+		return ADMISSION_REJECT_FULL;
+	}
+	return 0;
+}
+
+bool SteamMultiplayerPeer::_take_accept_token() {
+	if (accept_rate <= 0) {
+		return true;
+	}
+	uint64_t now = Time::get_singleton()->get_ticks_usec();
+	if (accept_tokens_at == 0) {
+		accept_tokens = accept_burst;
+	} else {
+		accept_tokens = MIN((double)accept_burst, accept_tokens + (now - accept_tokens_at) * accept_rate / 1000000.0);
+	}
+	accept_tokens_at = now;
+	if (accept_tokens < 1.0) {
+		return false;
+	}
+	accept_tokens -= 1.0;
+	return true;
+}
+
+// Accepts waiting connections in arrival order as tokens come in. Admission is checked again
+// since the host may have filled up or started refusing while they waited.
+void SteamMultiplayerPeer::_drain_pending_accepts() {
+	while (pending_accepts.size() > 0) {
+		HSteamNetConnection pending = pending_accepts.front()->get();
+		SteamNetConnectionInfo_t info;
+		int reason = 0;
+		if (SteamNetworkingSockets()->GetConnectionInfo(pending, &info)) {
+			reason = _get_admission_reject(_identity_key(info.m_identityRemote));
+		}
+		if (reason != 0) {
+			pending_accepts.pop_front();
+			_reject_connection(pending, reason);
+			continue;
+		}
+		if (!_take_accept_token()) {
+			return;
+		}
+		pending_accepts.pop_front();
+		_accept_connection(pending);
+	}
+}
+
+// RELAY PREWARM ///////////////////
+// The relay network is Steamworks only. GameNetworkingSockets builds report it as never ready.
+#define PING_LOCATION_BUFFER_SIZE k_cchMaxSteamNetworkingPingLocationString
+
+void SteamMultiplayerPeer::_ensure_relay_network_access() {
+#ifndef STEAM_PEER_GNS
+	ESteamNetworkingAvailability availability = SteamNetworkingUtils()->GetRelayNetworkStatus(nullptr);
+	if (availability != k_ESteamNetworkingAvailability_Current && availability != k_ESteamNetworkingAvailability_Attempting) {
+		SteamNetworkingUtils()->InitRelayNetworkAccess();
+	}
+#endif
+}
+
+// Empty until the relay network has measured one.
+String SteamMultiplayerPeer::_get_local_ping_location() const {
+#ifndef STEAM_PEER_GNS
+	if (SteamNetworkingUtils() != NULL) {
+		SteamNetworkPingLocation_t location;
+		if (SteamNetworkingUtils()->GetLocalPingLocation(location) >= 0) {
+			char buffer[PING_LOCATION_BUFFER_SIZE];
+			SteamNetworkingUtils()->ConvertPingLocationToString(location, buffer, PING_LOCATION_BUFFER_SIZE);
+			return String(buffer);
+		}
+	}
+#endif
+	return String();
+}
+
+// Starts relay discovery ahead of create_host/create_client. Emits relay_network_ready
+// once the relay network is usable, deferred if it already is.
+Error SteamMultiplayerPeer::prewarm() {
+#ifdef STEAM_PEER_GNS
+	ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "The relay network needs the Steamworks backend.");
+#endif
+	ERR_FAIL_COND_V_MSG(SteamNetworkingUtils() == NULL, ERR_UNAVAILABLE, "SteamNetworkingUtils is null!");
+	relay_prewarm_pending = true;
+	_ensure_relay_network_access();
+	if (is_relay_network_ready()) {
+		call_deferred("_on_relay_network_ready");
+	}
+	return OK;
+}
+
+void SteamMultiplayerPeer::_on_relay_network_ready() {
+	if (!relay_prewarm_pending) {
+		return;
+	}
+	relay_prewarm_pending = false;
+
+	String location_string = _get_local_ping_location();
+	if (!location_string.is_empty()) {
+		Ref<FileAccess> file = FileAccess::open(ping_location_cache_path, FileAccess::WRITE);
+		if (file.is_valid()) {
+			file->store_string(location_string);
+		} else {
+			WARN_PRINT(vformat("Failed to write ping location cache: %s", ping_location_cache_path));
+		}
+	} else {
+		location_string = get_cached_ping_location();
+	}
+	emit_signal("relay_network_ready", location_string);
+}
+
+bool SteamMultiplayerPeer::is_relay_network_ready() const {
+#ifdef STEAM_PEER_GNS
+	return false;
+#else
+	return SteamNetworkingUtils() != NULL && SteamNetworkingUtils()->GetRelayNetworkStatus(nullptr) == k_ESteamNetworkingAvailability_Current;
+#endif
+}
+
+// The live ping location when measured, otherwise the one cached by the last session.
+String SteamMultiplayerPeer::get_cached_ping_location() const {
+	String location = _get_local_ping_location();
+	if (!location.is_empty()) {
+		return location;
+	}
+	if (!FileAccess::file_exists(ping_location_cache_path)) {
+		return String();
+	}
+	return FileAccess::get_file_as_string(ping_location_cache_path).strip_edges();
+}
+
+void SteamMultiplayerPeer::set_ping_location_cache_path(const String &new_path) {
+	ping_location_cache_path = new_path;
+}
+
+String SteamMultiplayerPeer::get_ping_location_cache_path() const {
+	return ping_location_cache_path;
+}
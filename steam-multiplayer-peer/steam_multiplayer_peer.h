@@ -3,18 +3,18 @@
 
 #include <godot_cpp/classes/multiplayer_peer_extension.hpp>
 #include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/hashfuncs.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 // Include Steamworks API headers
 #include "map"
-#include "steam/steam_api_flat.h"
-#include "steam/steamnetworkingfakeip.h"
 #include "steam_connection.h"
+#include "steam_networking_api.h"
 #include "steam_peer_config.h"
 
 using namespace godot;
 
-#define MAX_PLAYERS_PER_SERVER 16
-
 class SteamMultiplayerPeer : public MultiplayerPeerExtension {
 	GDCLASS(SteamMultiplayerPeer, MultiplayerPeerExtension)
 
@@ -29,16 +29,231 @@ private:
 	uint32_t unique_id = 0;
 	_FORCE_INLINE_ bool _is_active() const { return active_mode != MODE_NONE; }
 	int32_t target_peer = -1;
+	// When not TARGET_GROUP_NONE, put_packet multicasts to every member of this group.
+	// Reset by _set_target_peer so SceneMultiplayer traffic is unaffected.
+	int32_t target_group = -1;
+	HashMap<int32_t, HashSet<int32_t>> peer_groups;
 	TransferMode transfer_mode = TRANSFER_MODE_RELIABLE;
+	// Applied to each put_packet like transfer_mode, see SteamConnection::_send_pending.
+	int32_t send_priority = 0;
+	int32_t send_ttl = 0; // milliseconds, 0 = never expires
+	int32_t send_queue_budget = 0; // bytes, 0 = no application-side queueing
+	uint64_t send_key = 0; // latest-value-wins key, 0 = unkeyed
+
+	// Unreliable stream coalescing. Must be enabled on both ends: every unreliable packet then
+	// carries a 4 byte header (u16 stream, u16 sequence, little endian). On receive, only the
+	// newest packet per sender and non-zero stream survives each poll, and older ones are dropped.
+	struct ReceiveStream {
+		uint16_t last_sequence = 0;
+		bool received = false;
+		uint64_t poll = UINT64_MAX;
+		List<Ref<SteamPacketPeer>>::Element *pending = nullptr;
+	};
+	bool stream_coalescing = false;
+	int32_t send_stream = 0;
+	HashMap<uint16_t, uint16_t> send_stream_sequences;
+	HashMap<uint64_t, ReceiveStream> receive_streams;
+	LocalVector<uint8_t> stream_scratch;
+	uint64_t coalesced_packets = 0;
+
+	// Jitter buffer for one coalescing stream. Packets on jitter_stream also carry the sender's
+	// u32 timestamp (usec) and are held per peer until a smoothed, jitter-adaptive playout time.
+	struct JitterEntry {
+		Ref<SteamPacketPeer> packet;
+		uint16_t sequence = 0;
+		int64_t release_at = 0;
+	};
+	struct JitterBuffer {
+		List<JitterEntry> pending; // ordered by sequence
+		bool synced = false;
+		uint32_t offset = 0; // baseline transit, the lowest recent (receive - send) time
+		uint32_t last_transit = 0;
+		int64_t jitter = 0; // RFC 3550 interarrival jitter, usec
+		int64_t playout_delay = 0; // usec
+		bool released = false;
+		uint16_t last_released = 0;
+	};
+	int32_t jitter_stream = 0;
+	int32_t jitter_min_delay = 0; // ms
+	int32_t jitter_max_delay = 200; // ms
+	HashMap<int32_t, JitterBuffer> jitter_buffers;
+	uint64_t late_packets = 0;
+
+	// Unreliable splitting. Must be enabled on both ends: every unreliable packet then carries a
+	// part count byte after its stream header. Messages over the MTU go out as that many parts,
+	// each with u8 index, u16 message id and u16 part size, so one lost part doesn't take the
+	// others with it the way Steam's own fragmentation does.
+	struct SplitMessage {
+		Ref<SteamPacketPeer> packet; // reassembled in place
+		uint64_t received_mask[4] = {};
+		uint8_t count = 0;
+		uint8_t received = 0;
+		uint16_t part_size = 0;
+		uint16_t sequence = 0;
+		uint32_t sent = 0;
+		int64_t started = 0; // Steam local timestamp of the first part, usec
+	};
+	bool split_unreliable = false;
+	int32_t split_timeout = 50; // ms
+	bool deliver_partial_messages = false;
+	int32_t split_mtu = 0; // cached smallest MTU_DataSize, 0 = stale
+	uint16_t split_message_id = 0;
+	HashMap<uint64_t, SplitMessage> split_messages; // peer_id << 16 | message id
+	LocalVector<uint8_t> split_scratch;
+	uint64_t incomplete_messages = 0;
+	int32_t _get_split_header_size(int p_flags) const;
+	int32_t _get_split_mtu();
+	Error _put_split(const uint8_t *p_buffer, int32_t p_prefix_size, int32_t p_size, int p_flags, uint16_t p_channel, bool p_relay_client);
+	void _expire_split_messages();
+	// Histograms, keyed by peer_id << 16 | channel. Channels are coalescing streams, 0 for
+	// every other packet.
+	struct ChannelHistograms {
+		SteamHistogram sent_size;
+		SteamHistogram received_size;
+		SteamHistogram consume_delay;
+	};
+	bool collect_histograms = false;
+	HashMap<uint64_t, ChannelHistograms> channel_histograms;
+	SteamHistogram poll_drain;
+	_FORCE_INLINE_ ChannelHistograms &_get_channel_histograms(int32_t p_peer, uint16_t p_channel) {
+		return channel_histograms[((uint64_t)(uint32_t)p_peer << 16) | p_channel];
+	}
+
+	// Packet objects constructed during the previous poll interval, see get_memory_stats.
+	uint64_t allocations_at_poll = 0;
+	uint64_t allocations_last_poll = 0;
+	bool performance_monitors = false;
+	// Index into memory_stat_names. Monitors read one stat each, so only its queues are walked.
+	int64_t _get_memory_stat(int p_stat) const;
+	int64_t _get_jitter_buffered(int64_t *r_bytes) const;
+	int64_t _get_pending(int64_t *r_bytes) const;
+
+	void _jitter_push(const Ref<SteamPacketPeer> &p_packet, uint16_t p_sequence, uint32_t p_sent, int64_t p_received);
+	void _deliver_packet(const Ref<SteamPacketPeer> &p_packet, uint16_t p_sequence, uint32_t p_sent);
+	Error _route_packet(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, uint16_t p_channel, bool p_relay_client);
+	void _release_jitter_buffers();
 	bool no_nagle = false;
 	bool no_delay = false;
 	// bool as_relay = false;
 	Ref<SteamPeerConfig> configs;
 
+	// Adaptive per-connection send rate. Every adaptive_rate_interval polls each connection's
+	// queue time and quality are sampled, its update rate scale in [0.1, 1] is backed off or
+	// grown, and SendRateMax is moved between the configured bounds accordingly.
+	bool adaptive_rate = false;
+	int32_t adaptive_rate_interval = 30;
+	int32_t adaptive_send_rate_min = 64 * 1024;
+	int32_t adaptive_send_rate_max = 1024 * 1024;
+	int32_t adaptive_target_queue_time = 50; // milliseconds
+	uint64_t poll_count = 0;
+	void _update_adaptive_rates();
+
+	// Relay prewarm. The last known ping location is cached on disk so it can be published
+	// for matchmaking at boot, before relay discovery has finished.
+	bool relay_prewarm_pending = false;
+	String ping_location_cache_path = "user://steam_ping_location.cache";
+	void _ensure_relay_network_access();
+	void _on_relay_network_ready();
+	String _get_local_ping_location() const;
+
+	// Fast reconnect. Within reconnect_grace_time a lost connection keeps its slot, peer id
+	// and queued reliable packets, and a reconnect from the same Steam ID resumes it.
+	int32_t reconnect_grace_time = 0; // milliseconds, 0 disables parking
+	HashMap<uint64_t, uint32_t> parked_slots;
+	uint64_t remote_steam_id = 0;
+	int remote_virtual_port = 0;
+	uint64_t last_reconnect_attempt = 0;
+
+	// IP transport. Connections without a Steam identity are keyed by a hash of their
+	// identity string, see _identity_key. Their peer id can't be derived on the client, so the
+	// host sends it as the first reliable message and the client stays connecting until then.
+	// That identity is an ip:port, which changes when a client redials, so clients also send a
+	// random session token as their first reliable message. The host registers IP connections
+	// only once it arrives, and keys those without a Steam ID on it.
+	bool ip_transport = false;
+	bool awaiting_peer_id = false;
+	SteamNetworkingIPAddr remote_ip_address;
+	uint64_t session_token = 0;
+	HashMap<HSteamNetConnection, uint64_t> awaiting_session; // connected, identity key until the token arrives
+	static uint64_t _identity_key(const SteamNetworkingIdentity &p_identity);
+	static bool _is_address_key(uint64_t p_key);
+	static bool _is_session_key(uint64_t p_key);
+	uint64_t _local_steam_id() const;
+	void _send_assigned_peer_id(HSteamNetConnection p_connection, int32_t p_peer_id);
+	static bool _read_assigned_peer_id(const SteamNetworkingMessage_t *p_msg, int32_t *r_peer_id);
+	bool _accept_assigned_peer_id(const SteamNetworkingMessage_t *p_msg);
+	void _send_session_token(HSteamNetConnection p_connection);
+	bool _accept_session_token(const SteamNetworkingMessage_t *p_msg);
+
+	// Native relay. Must be enabled on both ends: every packet then starts with an int32 peer
+	// field, the destination on client to host packets and the source on host to client ones.
+	// The host forwards client to client packets itself instead of passing them up to Godot.
+	enum RelayResult {
+		RELAY_DELIVER, // addressed to the host (too), process locally
+		RELAY_FORWARDED, // forwarded by copy or dropped, release it
+		RELAY_CONSUMED, // handed back to Steam, must not be released
+	};
+	bool native_relay = false;
+	uint64_t relayed_packets = 0;
+	static void _write_relay_header(uint8_t *w, int32_t p_peer);
+	RelayResult _relay_message(SteamNetworkingMessage_t *p_msg, const Ref<SteamConnection> &p_sender);
+
+	// Mesh. A native relay session where clients also link to each other directly. The host
+	// announces Steam IDs with peer field 0, the lower Steam ID of each pair dials, and
+	// packets take the direct link while it is up and the host relay otherwise.
+	enum MeshControl {
+		MESH_PEERS_ADDED = 1,
+		MESH_PEERS_REMOVED = 2,
+	};
+	bool mesh = false;
+	int mesh_virtual_port = 0;
+	HashMap<int32_t, uint64_t> mesh_peers; // client side, peer id -> Steam ID of every other client
+	void _send_mesh_control(const Ref<SteamConnection> &p_to, MeshControl p_type, const LocalVector<uint64_t> &p_steam_ids);
+	void _mesh_peer_joined(const Ref<SteamConnection> &p_peer);
+	void _mesh_peer_left(uint64_t p_steam_id);
+	void _handle_mesh_control(const uint8_t *p_data, uint32_t p_size);
+	void _accept_mesh_link(uint64_t p_steam_id, HSteamNetConnection p_connection, uint32_t p_slot);
+	void _close_mesh_link(const SteamNetConnectionStatusChangedCallback_t *call_data, int64_t p_slot);
+	int32_t _mesh_route(int32_t p_peer, int32_t &r_field) const;
+	Error _mesh_put(uint8_t *w, int32_t p_size, int p_flags, uint16_t p_channel);
+	bool _should_park(const SteamNetConnectionStatusChangedCallback_t *call_data, uint32_t p_slot) const;
+	void _park_connection(uint32_t p_slot);
+	Ref<SteamConnection> _resume_parked(uint32_t p_parked_slot, uint32_t p_fresh_slot);
+	void _expire_parked(uint64_t p_steam_id);
+	void _update_parked_connections();
+	void _handle_connection_closed(const SteamNetConnectionStatusChangedCallback_t *call_data, uint64_t steam_id);
+
+	// Admission control. Incoming connections are checked before AcceptConnection: refused or
+	// over capacity ones are closed with an AdmissionReject end reason right away, the rest
+	// take a token from a bucket refilled at accept_rate per second. Without a token they wait
+	// in pending_accepts, and once max_pending_accepts are waiting further ones are rejected too.
+	bool refuse_new_connections = false;
+	int32_t max_clients = 0; // 0 = unlimited
+	int32_t accept_rate = 0; // connections per second, 0 = unlimited
+	int32_t accept_burst = 8;
+	int32_t max_pending_accepts = 32;
+	double accept_tokens = 0;
+	uint64_t accept_tokens_at = 0; // usec
+	List<HSteamNetConnection> pending_accepts;
+	HashSet<HSteamNetConnection> accepting; // accepted, not connected yet
+	uint64_t rejected_connections = 0;
+	void _admit_connection(HSteamNetConnection p_connection, uint64_t p_steam_id);
+	void _accept_connection(HSteamNetConnection p_connection);
+	void _reject_connection(HSteamNetConnection p_connection, int p_reason);
+	int _get_admission_reject(uint64_t p_steam_id) const;
+	bool _take_accept_token();
+	void _drain_pending_accepts();
+
 protected:
 	static void _bind_methods();
 
 public:
+	// End reasons for connections refused by admission control.
+	enum AdmissionReject {
+		ADMISSION_REJECT_REFUSING = k_ESteamNetConnectionEnd_App_Min + 1,
+		ADMISSION_REJECT_FULL = k_ESteamNetConnectionEnd_App_Min + 2,
+		ADMISSION_REJECT_BUSY = k_ESteamNetConnectionEnd_App_Min + 3,
+	};
 	enum SocketConnectionType {
 		NET_SOCKET_CONNECTION_TYPE_NOT_CONNECTED = k_ESNetSocketConnectionTypeNotConnected,
 		NET_SOCKET_CONNECTION_TYPE_UDP = k_ESNetSocketConnectionTypeUDP,
@@ -165,21 +380,33 @@ public:
 	void _close() override;
 	void _disconnect_peer(int32_t p_peer, bool p_force) override;
 	int32_t _get_unique_id() const override;
-	// void _set_refuse_new_connections(bool p_enable) override;
-	// bool _is_refusing_new_connections() const override;
+	void _set_refuse_new_connections(bool p_enable) override;
+	bool _is_refusing_new_connections() const override;
 	bool _is_server_relay_supported() const override;
 	MultiplayerPeer::ConnectionStatus _get_connection_status() const override;
 
 	bool close_listen_socket();
 	Error create_host(int n_local_virtual_port);
 	Error create_client(uint64_t identity_remote, int n_remote_virtual_port);
+	Error create_host_ip(const String &address, int port);
+	/// Native relay
+	void set_native_relay(const bool new_native_relay);
+	bool get_native_relay() const;
+	uint64_t get_relayed_packet_count() const;
+	/// Mesh
+	Error create_mesh(uint64_t host_steam_id, int n_virtual_port);
+	bool is_mesh() const;
+	bool has_mesh_link(int32_t peer_id) const;
+	Error create_client_ip(const String &address, int port);
 	bool get_identity(SteamNetworkingIdentity *p_identity);
 	const SteamNetworkingConfigValue_t *convert_options_array(Array options);
 	Ref<SteamConnection> get_connection_by_peer(int peer_id);
 	void add_connection(const uint64_t steam_id, HSteamNetConnection connection);
 
-	void _process_message(const SteamNetworkingMessage_t *msg);
-	void _process_ping(const SteamNetworkingMessage_t *msg);
+	void _process_message(const SteamNetworkingMessage_t *msg, const Ref<SteamConnection> &sender);
+	void _on_connection_established(uint64_t steam_id, HSteamNetConnection p_connection);
+	void _drop_stale_connection(uint32_t p_slot);
+	static int32_t _derive_peer_id(uint64_t steam_id);
 
 	uint64_t get_steam64_from_peer_id(const uint32_t peer_id) const; //Steam64 is a Steam ID
 	uint32_t get_peer_id_from_steam64(const uint64_t steamid) const;
@@ -205,20 +432,162 @@ public:
 	void set_config(const SteamPeerConfig::SteamNetworkingConfig config, Variant value);
 	void clear_config(const SteamPeerConfig::SteamNetworkingConfig config);
 	void clear_all_configs();
+	Error apply_configs_to_peer(int peer_id);
+	Error apply_configs_to_all_peers();
+	/// Adaptive send rate
+	void set_adaptive_rate(const bool new_adaptive_rate);
+	bool get_adaptive_rate() const;
+	void set_adaptive_rate_interval(const int32_t new_interval);
+	int32_t get_adaptive_rate_interval() const;
+	void set_adaptive_send_rate_min(const int32_t new_rate);
+	int32_t get_adaptive_send_rate_min() const;
+	void set_adaptive_send_rate_max(const int32_t new_rate);
+	int32_t get_adaptive_send_rate_max() const;
+	void set_adaptive_target_queue_time(const int32_t new_time);
+	int32_t get_adaptive_target_queue_time() const;
+	float get_peer_update_rate(int peer_id);
+	int32_t get_peer_send_rate(int peer_id);
+	/// Send scheduling
+	void set_send_priority(const int32_t new_priority);
+	int32_t get_send_priority() const;
+	void set_send_ttl(const int32_t new_ttl);
+	int32_t get_send_ttl() const;
+	void set_send_key(const uint64_t new_key);
+	uint64_t get_send_key() const;
+	/// Unreliable stream coalescing
+	void set_stream_coalescing(const bool new_stream_coalescing);
+	bool get_stream_coalescing() const;
+	void set_send_stream(const int32_t new_stream);
+	int32_t get_send_stream() const;
+	uint64_t get_coalesced_packet_count() const;
+	/// Jitter buffer
+	void set_jitter_stream(const int32_t new_stream);
+	int32_t get_jitter_stream() const;
+	void set_jitter_min_delay(const int32_t new_delay);
+	int32_t get_jitter_min_delay() const;
+	void set_jitter_max_delay(const int32_t new_delay);
+	int32_t get_jitter_max_delay() const;
+	float get_peer_jitter(int32_t peer_id) const;
+	float get_peer_playout_delay(int32_t peer_id) const;
+	uint64_t get_late_packet_count() const;
+	/// Unreliable splitting
+	void set_split_unreliable(const bool new_split_unreliable);
+	bool get_split_unreliable() const;
+	void set_split_timeout(const int32_t new_timeout);
+	int32_t get_split_timeout() const;
+	void set_deliver_partial_messages(const bool new_deliver_partial);
+	bool get_deliver_partial_messages() const;
+	bool is_last_packet_partial() const;
+	uint64_t get_incomplete_message_count() const;
+	/// Zero-copy sends, native only. begin_message returns p_size writable bytes inside a Steam
+	/// allocated message. commit_message hands it to Steam for p_peer (as in set_target_peer)
+	/// and discard_message frees it unsent. The message must not be touched after either call.
+	/// Reliable messages Steam's send buffer has no room for are copied into the retry queue,
+	/// as put_packet does, so they are never lost.
+	uint8_t *begin_message(int32_t p_size, MultiplayerPeer::TransferMode p_mode, SteamNetworkingMessage_t **r_message);
+	Error commit_message(SteamNetworkingMessage_t *p_message, int32_t p_peer);
+	void discard_message(SteamNetworkingMessage_t *p_message);
+	/// Pops the next received packet without copying it, null when none is queued.
+	Ref<SteamPacketPeer> take_packet();
+	Error dump_network_trace(const String &path);
+	/// Memory accounting
+	Dictionary get_memory_stats() const;
+	Variant get_memory_stat(const String &name) const;
+	void add_performance_monitors();
+	void remove_performance_monitors();
+	/// Histograms
+	void set_collect_histograms(const bool new_collect_histograms);
+	bool get_collect_histograms() const;
+	Dictionary get_histograms() const;
+	void reset_histograms();
+	/// Batches
+	Array get_packets_batch(int32_t max);
+	Error put_packets_batch(const PackedByteArray &payloads, const PackedInt32Array &records);
+	void set_send_queue_budget(const int32_t new_budget);
+	int32_t get_send_queue_budget() const;
+	/// Fast reconnect
+	void set_reconnect_grace_time(const int32_t new_grace_time);
+	int32_t get_reconnect_grace_time() const;
+	/// Admission control
+	void set_max_clients(const int32_t new_max_clients);
+	int32_t get_max_clients() const;
+	void set_accept_rate(const int32_t new_accept_rate);
+	int32_t get_accept_rate() const;
+	void set_accept_burst(const int32_t new_accept_burst);
+	int32_t get_accept_burst() const;
+	void set_max_pending_accepts(const int32_t new_max_pending);
+	int32_t get_max_pending_accepts() const;
+	int32_t get_pending_accept_count() const;
+	uint64_t get_rejected_connection_count() const;
+	/// Relay prewarm
+	Error prewarm();
+	bool is_relay_network_ready() const;
+	String get_cached_ping_location() const;
+	void set_ping_location_cache_path(const String &new_path);
+	String get_ping_location_cache_path() const;
+	/// Interest groups
+	void set_target_group(int32_t group);
+	int32_t get_target_group() const;
+	void add_peer_to_group(int32_t group, int32_t peer_id);
+	void remove_peer_from_group(int32_t group, int32_t peer_id);
+	void clear_group(int32_t group);
+	PackedInt32Array get_group_peers(int32_t group) const;
 
 private:
-	HashMap<uint64_t, Ref<SteamConnection>> connections_by_steamId64;
-	HashMap<int, Ref<SteamConnection>> peerId_to_steamId;
-	HSteamListenSocket listen_socket;
+	static const int32_t TARGET_GROUP_NONE = -1;
+
+	// Connections live in a dense slot table. The slot index and its generation are
+	// packed into the Steam connection user data, so a received message maps back to
+	// its connection through m_nConnUserData without hashing the sender's Steam ID.
+	struct ConnectionSlot {
+		Ref<SteamConnection> connection;
+		uint32_t generation = 1;
+	};
+	LocalVector<ConnectionSlot> connection_slots;
+	LocalVector<uint32_t> free_slots;
+	HashMap<uint64_t, uint32_t> slot_by_steam_id;
+	HashMap<int32_t, uint32_t> slot_by_peer_id;
+	HSteamListenSocket listen_socket = k_HSteamListenSocket_Invalid;
 	HSteamNetConnection connection;
 
+	_FORCE_INLINE_ static int64_t _make_slot_user_data(uint32_t p_slot, uint32_t p_generation) { return ((int64_t)p_generation << 32) | p_slot; }
+	int64_t _find_slot(int64_t p_user_data, uint64_t p_steam_id) const;
+	int64_t _find_slot_by_user_data(int64_t p_user_data) const;
+	int64_t _find_message_slot(const SteamNetworkingMessage_t *p_message) const;
+	Ref<SteamConnection> _get_connection_by_slot(int64_t p_slot) const;
+	void _remove_connection(uint32_t p_slot);
+	void _clear_connections();
+
 	Ref<SteamPacketPeer> next_received_packet; // gets deleted at the very first get_packet request
+	const Ref<SteamPacketPeer> &_pop_incoming_packet();
 	List<Ref<SteamPacketPeer>> incoming_packets;
 	const int _get_steam_transfer_flag();
+	const int _get_steam_transfer_flag(MultiplayerPeer::TransferMode p_mode);
+	int32_t _get_stream_header_size(int p_flags) const;
+	void _write_stream_header(uint8_t *w, int32_t p_header_size);
+	void _collect_targets(int32_t p_peer, int32_t p_group, LocalVector<Ref<SteamConnection>> &r_targets) const;
+	Ref<SteamPacketPeer> _make_packet(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, bool p_relayed = false) const;
+	bool _has_send_buffer_room(const Ref<SteamConnection> &p_connection, int32_t p_size) const;
+	Error _multicast(const uint8_t *p_buffer, int32_t p_buffer_size, int p_flags, const LocalVector<Ref<SteamConnection>> &p_targets, bool p_relayed = false);
 	ConnectionStatus connection_status = ConnectionStatus::CONNECTION_DISCONNECTED;
 
 	// Networking Sockets callbacks /////////
-	STEAM_CALLBACK(SteamMultiplayerPeer, network_connection_status_changed, SteamNetConnectionStatusChangedCallback_t, callback_network_connection_status_changed);
+	// Dispatched by SteamNetworkingHub, which queues connection state changes and messages for
+	// the sockets this peer claimed. Both are handled at the start of _poll, changes first.
+	friend class SteamNetworkingHub;
+	friend class SteamPeerTests; // injects connection losses, see tests/src
+	LocalVector<SteamNetConnectionStatusChangedCallback_t> status_events;
+	LocalVector<SteamNetworkingMessage_t *> incoming_messages;
+	LocalVector<SteamNetworkingMessage_t *> processing_messages;
+	LocalVector<SteamNetworkingConfigValue_t> connection_options;
+	const SteamNetworkingConfigValue_t *_get_connection_options();
+	int _get_connection_option_count() const;
+	void _close_connection_handle(HSteamNetConnection p_connection, int p_reason, const char *p_debug);
+	void _process_status_events();
+	void _process_status_event(const SteamNetConnectionStatusChangedCallback_t *call_data);
+#ifndef STEAM_PEER_GNS
+	void relay_network_status_changed(SteamRelayNetworkStatus_t *call_data);
+#endif
 };
 
 #endif // STEAM_MULTIPLAYER_PEER_H
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef STEAM_NETWORKING_API_H
+#define STEAM_NETWORKING_API_H
+
+// The networking API the extension is built against, picked with the networking_backend
+// SCons option. The default is the Steamworks SDK. STEAM_PEER_GNS builds against the open
+// source GameNetworkingSockets instead: the same ISteamNetworkingSockets interface, but
+// no Steam user, no relay network and no P2P rendezvous, so only the IP transport works.
+#ifdef STEAM_PEER_GNS
+#include "steam/isteamnetworkingutils.h"
+#include "steam/steamnetworkingsockets.h"
+#else
+#include "steam/steam_api_flat.h"
+#include "steam/steamnetworkingfakeip.h"
+#endif
+
+#endif // STEAM_NETWORKING_API_H
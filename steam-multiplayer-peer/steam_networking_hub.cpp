@@ -0,0 +1,210 @@
+#include "steam_networking_hub.h"
+
+#include "steam_multiplayer_peer.h"
+#include "steam_trace.h"
+
+#define HUB_MESSAGE_BATCH 255
+// Per owner. Past it, a peer that others out-poll leaves its messages in Steam's queues.
+#define HUB_MAX_QUEUED_MESSAGES 8192
+
+SteamNetworkingHub *SteamNetworkingHub::singleton = nullptr;
+
+#ifdef STEAM_PEER_GNS
+SteamNetworkingHub::SteamNetworkingHub() {
+}
+#else
+SteamNetworkingHub::SteamNetworkingHub() :
+		callback_network_connection_status_changed(this, &SteamNetworkingHub::network_connection_status_changed),
+		callback_relay_network_status_changed(this, &SteamNetworkingHub::relay_network_status_changed) {
+}
+#endif
+
+SteamNetworkingHub::~SteamNetworkingHub() {
+#ifdef STEAM_PEER_GNS
+	if (!library_initialized) {
+		return;
+	}
+#endif
+	if (poll_group != k_HSteamNetPollGroup_Invalid && SteamNetworkingSockets() != NULL) {
+		SteamNetworkingSockets()->DestroyPollGroup(poll_group);
+	}
+#ifdef STEAM_PEER_GNS
+	GameNetworkingSockets_Kill();
+#endif
+}
+
+bool SteamNetworkingHub::init_sockets() {
+#ifdef STEAM_PEER_GNS
+	if (!library_initialized) {
+		SteamNetworkingErrMsg error;
+		ERR_FAIL_COND_V_MSG(!GameNetworkingSockets_Init(nullptr, error), false, vformat("GameNetworkingSockets failed to initialize: %s", error));
+		library_initialized = true;
+	}
+	return true;
+#else
+	return SteamNetworkingSockets() != NULL;
+#endif
+}
+
+void SteamNetworkingHub::register_peer(SteamMultiplayerPeer *p_peer) {
+	if (singleton == nullptr) {
+		singleton = memnew(SteamNetworkingHub);
+	}
+	singleton->peers.push_back(p_peer);
+}
+
+void SteamNetworkingHub::unregister_peer(SteamMultiplayerPeer *p_peer) {
+	ERR_FAIL_NULL(singleton);
+	singleton->release_peer(p_peer);
+	singleton->peers.erase(p_peer);
+	if (singleton->peers.size() == 0) {
+		memdelete(singleton);
+		singleton = nullptr;
+	}
+}
+
+void SteamNetworkingHub::connection_status_changed(SteamNetConnectionStatusChangedCallback_t *call_data) {
+	if (singleton != nullptr) {
+		singleton->_route_status_change(call_data);
+	}
+}
+
+#ifndef STEAM_PEER_GNS
+void SteamNetworkingHub::network_connection_status_changed(SteamNetConnectionStatusChangedCallback_t *call_data) {
+	_route_status_change(call_data);
+}
+
+//! Relay availability is process wide, every peer hears about it.
+void SteamNetworkingHub::relay_network_status_changed(SteamRelayNetworkStatus_t *call_data) {
+	for (uint32_t i = 0; i < peers.size(); i++) {
+		peers[i]->relay_network_status_changed(call_data);
+	}
+}
+#endif
+
+// Known connections go by handle, new ones arriving on a listen socket by that socket.
+SteamMultiplayerPeer *SteamNetworkingHub::_find_owner(const SteamNetConnectionStatusChangedCallback_t *call_data) const {
+	HashMap<HSteamNetConnection, SteamMultiplayerPeer *>::ConstIterator C = connections.find(call_data->m_hConn);
+	if (C) {
+		return C->value;
+	}
+	if (call_data->m_info.m_hListenSocket != k_HSteamListenSocket_Invalid) {
+		HashMap<HSteamListenSocket, SteamMultiplayerPeer *>::ConstIterator L = listen_sockets.find(call_data->m_info.m_hListenSocket);
+		if (L) {
+			return L->value;
+		}
+	}
+	return nullptr;
+}
+
+void SteamNetworkingHub::_route_status_change(const SteamNetConnectionStatusChangedCallback_t *call_data) {
+	SteamMultiplayerPeer *owner = _find_owner(call_data);
+	if (owner != nullptr && owner->_is_active()) {
+		owner->status_events.push_back(*call_data);
+	}
+}
+
+void SteamNetworkingHub::claim_listen_socket(HSteamListenSocket p_socket, SteamMultiplayerPeer *p_peer) {
+	listen_sockets[p_socket] = p_peer;
+}
+
+void SteamNetworkingHub::release_listen_socket(HSteamListenSocket p_socket) {
+	listen_sockets.erase(p_socket);
+}
+
+void SteamNetworkingHub::claim_connection(HSteamNetConnection p_connection, SteamMultiplayerPeer *p_peer) {
+	ERR_FAIL_COND(p_connection == k_HSteamNetConnection_Invalid);
+	if (poll_group == k_HSteamNetPollGroup_Invalid) {
+		poll_group = SteamNetworkingSockets()->CreatePollGroup();
+	}
+	connections[p_connection] = p_peer;
+	if (!throttled_peers.has(p_peer)) {
+		SteamNetworkingSockets()->SetConnectionPollGroup(p_connection, poll_group);
+	}
+}
+
+void SteamNetworkingHub::release_connection(HSteamNetConnection p_connection) {
+	connections.erase(p_connection);
+}
+
+void SteamNetworkingHub::release_peer(SteamMultiplayerPeer *p_peer) {
+	throttled_peers.erase(p_peer);
+	LocalVector<HSteamNetConnection> owned_connections;
+	for (const KeyValue<HSteamNetConnection, SteamMultiplayerPeer *> &E : connections) {
+		if (E.value == p_peer) {
+			owned_connections.push_back(E.key);
+		}
+	}
+	for (uint32_t i = 0; i < owned_connections.size(); i++) {
+		connections.erase(owned_connections[i]);
+	}
+	LocalVector<HSteamListenSocket> owned_sockets;
+	for (const KeyValue<HSteamListenSocket, SteamMultiplayerPeer *> &E : listen_sockets) {
+		if (E.value == p_peer) {
+			owned_sockets.push_back(E.key);
+		}
+	}
+	for (uint32_t i = 0; i < owned_sockets.size(); i++) {
+		listen_sockets.erase(owned_sockets[i]);
+	}
+}
+
+// Any peer's _poll drives this. Messages for connections nobody owns any more are released.
+void SteamNetworkingHub::poll() {
+	STEAM_TRACE_ZONE("SteamNetworkingHub::poll");
+	SteamNetworkingSockets()->RunCallbacks();
+	if (poll_group == k_HSteamNetPollGroup_Invalid) {
+		return;
+	}
+	if (throttled_peers.size() > 0) {
+		_resume_drained_peers();
+	}
+
+	SteamNetworkingMessage_t *messages[HUB_MESSAGE_BATCH];
+	int count;
+	do {
+		count = SteamNetworkingSockets()->ReceiveMessagesOnPollGroup(poll_group, messages, HUB_MESSAGE_BATCH);
+		STEAM_TRACE_VALUE(count);
+		for (int i = 0; i < count; i++) {
+			HashMap<HSteamNetConnection, SteamMultiplayerPeer *>::ConstIterator C = connections.find(messages[i]->m_conn);
+			if (C && C->value->_is_active()) {
+				// Already received, so kept even past the cap. Later ones stay in Steam.
+				C->value->incoming_messages.push_back(messages[i]);
+				if (C->value->incoming_messages.size() >= HUB_MAX_QUEUED_MESSAGES && !throttled_peers.has(C->value)) {
+					_throttle_peer(C->value);
+				}
+			} else {
+				messages[i]->Release();
+			}
+		}
+	} while (count == HUB_MESSAGE_BATCH);
+}
+
+// Takes the peer's connections out of the shared poll group. Steam keeps queueing their
+// messages per connection, acked reliable ones included, until the peer catches up.
+void SteamNetworkingHub::_throttle_peer(SteamMultiplayerPeer *p_peer) {
+	throttled_peers.insert(p_peer);
+	for (const KeyValue<HSteamNetConnection, SteamMultiplayerPeer *> &E : connections) {
+		if (E.value == p_peer) {
+			SteamNetworkingSockets()->SetConnectionPollGroup(E.key, k_HSteamNetPollGroup_Invalid);
+		}
+	}
+}
+
+// Moving a connection back into the poll group also moves the messages Steam held for it.
+void SteamNetworkingHub::_resume_drained_peers() {
+	LocalVector<SteamMultiplayerPeer *> drained;
+	for (SteamMultiplayerPeer *peer : throttled_peers) {
+		if (peer->incoming_messages.size() < HUB_MAX_QUEUED_MESSAGES) {
+			drained.push_back(peer);
+		}
+	}
+	for (uint32_t i = 0; i < drained.size(); i++) {
+		throttled_peers.erase(drained[i]);
+		for (const KeyValue<HSteamNetConnection, SteamMultiplayerPeer *> &E : connections) {
+			if (E.value == drained[i]) {
+				SteamNetworkingSockets()->SetConnectionPollGroup(E.key, poll_group);
+			}
+		}
+	}
+}
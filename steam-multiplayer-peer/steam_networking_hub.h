@@ -0,0 +1,68 @@
+#ifndef STEAM_NETWORKING_HUB_H
+#define STEAM_NETWORKING_HUB_H
+
+#include <godot_cpp/core/memory.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/hash_set.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include "steam_networking_api.h"
+
+using namespace godot;
+
+class SteamMultiplayerPeer;
+
+// Process wide owner of Steam's connection callbacks and of one poll group shared by every
+// SteamMultiplayerPeer, so several peers can run side by side. State changes and messages are
+// routed to the peer that claimed the listen socket or connection handle, and queued there
+// until that peer's _poll. Lives while at least one peer is registered.
+class SteamNetworkingHub {
+	static SteamNetworkingHub *singleton;
+
+	LocalVector<SteamMultiplayerPeer *> peers;
+	HashMap<HSteamListenSocket, SteamMultiplayerPeer *> listen_sockets;
+	HashMap<HSteamNetConnection, SteamMultiplayerPeer *> connections;
+	HSteamNetPollGroup poll_group = k_HSteamNetPollGroup_Invalid;
+	// Peers with a full queue, whose connections are out of the poll group until they poll.
+	HashSet<SteamMultiplayerPeer *> throttled_peers;
+
+	SteamMultiplayerPeer *_find_owner(const SteamNetConnectionStatusChangedCallback_t *call_data) const;
+	void _route_status_change(const SteamNetConnectionStatusChangedCallback_t *call_data);
+	void _throttle_peer(SteamMultiplayerPeer *p_peer);
+	void _resume_drained_peers();
+
+	SteamNetworkingHub();
+
+#ifdef STEAM_PEER_GNS
+	bool library_initialized = false;
+#else
+	// Only posted for connections made without the per-socket callback.
+	STEAM_CALLBACK(SteamNetworkingHub, network_connection_status_changed, SteamNetConnectionStatusChangedCallback_t, callback_network_connection_status_changed);
+	STEAM_CALLBACK(SteamNetworkingHub, relay_network_status_changed, SteamRelayNetworkStatus_t, callback_relay_network_status_changed);
+#endif
+
+public:
+	~SteamNetworkingHub();
+
+	static SteamNetworkingHub *get_singleton() { return singleton; }
+	static void register_peer(SteamMultiplayerPeer *p_peer);
+	static void unregister_peer(SteamMultiplayerPeer *p_peer);
+	// Value for k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged.
+	static void connection_status_changed(SteamNetConnectionStatusChangedCallback_t *call_data);
+
+	// True once the sockets interface is usable. The game initializes Steamworks itself,
+	// GameNetworkingSockets is initialized here on first use.
+	bool init_sockets();
+
+	void claim_listen_socket(HSteamListenSocket p_socket, SteamMultiplayerPeer *p_peer);
+	void release_listen_socket(HSteamListenSocket p_socket);
+	// Claimed connections also join the shared poll group.
+	void claim_connection(HSteamNetConnection p_connection, SteamMultiplayerPeer *p_peer);
+	void release_connection(HSteamNetConnection p_connection);
+	void release_peer(SteamMultiplayerPeer *p_peer);
+
+	// Runs queued socket callbacks and drains the shared poll group into the owners' queues.
+	void poll();
+};
+
+#endif // STEAM_NETWORKING_HUB_H
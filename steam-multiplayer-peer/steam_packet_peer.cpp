@@ -1,14 +1,23 @@
 #include "steam_packet_peer.h"
+#include "steam_memory_stats.h"
 
 void SteamPacketPeer::_bind_methods() {
 }
 
 SteamPacketPeer::SteamPacketPeer() {
+	SteamMemoryStats::add(SteamMemoryStats::live_packet_peers, 1);
+	SteamMemoryStats::packet_allocations.fetch_add(1, std::memory_order_relaxed);
 }
 
 SteamPacketPeer::SteamPacketPeer(const void *p_buffer, uint32_t p_buffer_size, int transferMode) {
+	SteamMemoryStats::add(SteamMemoryStats::live_packet_peers, 1);
+	SteamMemoryStats::packet_allocations.fetch_add(1, std::memory_order_relaxed);
 	ERR_FAIL_COND_MSG(p_buffer_size > MAX_STEAM_PACKET_SIZE, vformat("Error: Tried to send a packet larger than MAX_STEAM_PACKET_SIZE: %d", p_buffer_size));
 	memcpy(this->data, p_buffer, p_buffer_size);
 	this->size = p_buffer_size;
 	this->transfer_mode = transferMode;
-}
\ No newline at end of file
+}
+
+SteamPacketPeer::~SteamPacketPeer() {
+	SteamMemoryStats::add(SteamMemoryStats::live_packet_peers, -1);
+}
@@ -1,7 +1,7 @@
 #ifndef STEAM_PACKET_PEER_H
 #define STEAM_PACKET_PEER_H
 
-#include "steam/steam_api_flat.h"
+#include "steam_networking_api.h"
 #include <godot_cpp/classes/os.hpp>
 #include <godot_cpp/classes/ref_counted.hpp>
 
@@ -28,9 +28,23 @@ public:
 	uint8_t data[MAX_STEAM_PACKET_SIZE];
 	uint32_t size = 0;
 	uint64_t sender;
+	int32_t peer_id = 0;
 	int transfer_mode = SEND_RELIABLE;
+	// Scheduling, see SteamConnection::_send_pending. Higher priorities are released first,
+	// unreliable packets still queued past their deadline (usec, 0 = none) are dropped.
+	int32_t priority = 0;
+	uint64_t deadline = 0;
+	// Non-zero keys replace a queued packet with the same key instead of queueing behind it.
+	uint64_t key = 0;
+	// Histogram bookkeeping, Steam local timestamps (usec). The channel is the coalescing stream.
+	uint16_t channel = 0;
+	int64_t queued_at = 0;
+	int64_t received_at = 0;
+	// Split messages delivered after a timeout, missing parts are zero filled.
+	bool partial = false;
 	SteamPacketPeer();
 	SteamPacketPeer(const void *p_buffer, uint32_t p_buffer_size, int transferMode);
+	~SteamPacketPeer();
 
 protected:
 	static void _bind_methods();
@@ -0,0 +1,160 @@
+#include "steam_packet_reader.h"
+#include "steam_packet_writer.h"
+
+#include <godot_cpp/core/class_db.hpp>
+
+void SteamPacketReader::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("read_next", "peer"), &SteamPacketReader::read_next);
+	ClassDB::bind_method(D_METHOD("set_data", "bytes"), &SteamPacketReader::set_data);
+	ClassDB::bind_method(D_METHOD("get_packet_peer"), &SteamPacketReader::get_packet_peer);
+	ClassDB::bind_method(D_METHOD("get_packet_mode"), &SteamPacketReader::get_packet_mode);
+	ClassDB::bind_method(D_METHOD("read_bool"), &SteamPacketReader::read_bool);
+	ClassDB::bind_method(D_METHOD("read_uint", "bits"), &SteamPacketReader::read_uint);
+	ClassDB::bind_method(D_METHOD("read_int", "bits"), &SteamPacketReader::read_int);
+	ClassDB::bind_method(D_METHOD("read_varint"), &SteamPacketReader::read_varint);
+	ClassDB::bind_method(D_METHOD("read_enum", "count"), &SteamPacketReader::read_enum);
+	ClassDB::bind_method(D_METHOD("read_float"), &SteamPacketReader::read_float);
+	ClassDB::bind_method(D_METHOD("read_quantized_float", "min", "max", "bits"), &SteamPacketReader::read_quantized_float);
+	ClassDB::bind_method(D_METHOD("read_bytes"), &SteamPacketReader::read_bytes);
+	ClassDB::bind_method(D_METHOD("align"), &SteamPacketReader::align);
+	ClassDB::bind_method(D_METHOD("get_remaining_bits"), &SteamPacketReader::get_remaining_bits);
+	ClassDB::bind_method(D_METHOD("is_overflowed"), &SteamPacketReader::is_overflowed);
+}
+
+// Takes the next received packet from peer and reads its buffer in place.
+Error SteamPacketReader::read_next(const Ref<SteamMultiplayerPeer> &peer) {
+	ERR_FAIL_COND_V(peer.is_null(), ERR_INVALID_PARAMETER);
+	Ref<SteamPacketPeer> next = peer->take_packet();
+	if (next.is_null()) {
+		return ERR_UNAVAILABLE;
+	}
+	bytes = PackedByteArray();
+	packet = next;
+	reset(packet->data, packet->size);
+	return OK;
+}
+
+void SteamPacketReader::set_data(const PackedByteArray &new_bytes) {
+	packet.unref();
+	bytes = new_bytes;
+	reset(bytes.ptr(), bytes.size());
+}
+
+// Native callers can point the reader at any buffer that outlives the reads.
+void SteamPacketReader::reset(const uint8_t *p_data, uint32_t p_size) {
+	data = p_data;
+	bit_size = (uint64_t)p_size * 8;
+	bit_position = 0;
+	overflowed = false;
+}
+
+int32_t SteamPacketReader::get_packet_peer() const {
+	ERR_FAIL_COND_V_MSG(packet.is_null(), 0, "The reader is not reading a received packet.");
+	return packet->peer_id;
+}
+
+MultiplayerPeer::TransferMode SteamPacketReader::get_packet_mode() const {
+	ERR_FAIL_COND_V_MSG(packet.is_null(), MultiplayerPeer::TRANSFER_MODE_RELIABLE, "The reader is not reading a received packet.");
+	return (packet->transfer_mode & k_nSteamNetworkingSend_Reliable) ? MultiplayerPeer::TRANSFER_MODE_RELIABLE : MultiplayerPeer::TRANSFER_MODE_UNRELIABLE;
+}
+
+uint64_t SteamPacketReader::read_bits(int bits) {
+	ERR_FAIL_COND_V(bits < 0 || bits > 64, 0);
+	if (overflowed || bit_position + bits > bit_size) {
+		overflowed = true;
+		return 0;
+	}
+	uint64_t value = 0;
+	int shift = 0;
+	while (bits > 0) {
+		int offset = bit_position & 7;
+		int take = MIN(8 - offset, bits);
+		uint64_t chunk = (data[bit_position >> 3] >> offset) & ((1u << take) - 1);
+		value |= chunk << shift;
+		shift += take;
+		bits -= take;
+		bit_position += take;
+	}
+	return value;
+}
+
+bool SteamPacketReader::read_bool() {
+	return read_bits(1) != 0;
+}
+
+int64_t SteamPacketReader::read_uint(int bits) {
+	return (int64_t)read_bits(bits);
+}
+
+int64_t SteamPacketReader::read_int(int bits) {
+	ERR_FAIL_COND_V(bits < 1 || bits > 64, 0);
+	uint64_t value = read_bits(bits);
+	if (bits < 64 && (value >> (bits - 1)) & 1) {
+		value |= UINT64_MAX << bits; // sign extend
+	}
+	return (int64_t)value;
+}
+
+int64_t SteamPacketReader::read_varint() {
+	uint64_t zigzag = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint64_t group = read_bits(8);
+		zigzag |= (group & 0x7F) << shift;
+		if (!(group & 0x80)) {
+			return (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+		}
+	}
+	overflowed = true;
+	return 0;
+}
+
+int64_t SteamPacketReader::read_enum(int count) {
+	int64_t value = read_bits(SteamPacketWriter::bits_for_count(count));
+	if (value >= count) {
+		overflowed = true;
+		return 0;
+	}
+	return value;
+}
+
+float SteamPacketReader::read_float() {
+	uint32_t raw = read_bits(32);
+	float value;
+	memcpy(&value, &raw, sizeof(value));
+	return value;
+}
+
+float SteamPacketReader::read_quantized_float(float min, float max, int bits) {
+	ERR_FAIL_COND_V(bits < 1 || bits > 32, 0.0f);
+	uint64_t steps = (UINT64_C(1) << bits) - 1;
+	return min + (double)read_bits(bits) / steps * ((double)max - min);
+}
+
+PackedByteArray SteamPacketReader::read_bytes() {
+	PackedByteArray result;
+	int64_t size = read_varint();
+	if (size < 0 || (uint64_t)size * 8 > bit_size - bit_position) {
+		overflowed = true;
+		return result;
+	}
+	result.resize(size);
+	uint8_t *w = result.ptrw();
+	for (int64_t i = 0; i < size; i++) {
+		w[i] = read_bits(8);
+	}
+	return result;
+}
+
+void SteamPacketReader::align() {
+	if (bit_position & 7) {
+		read_bits(8 - (bit_position & 7));
+	}
+}
+
+int64_t SteamPacketReader::get_remaining_bits() const {
+	return overflowed ? 0 : bit_size - bit_position;
+}
+
+bool SteamPacketReader::is_overflowed() const {
+	return overflowed;
+}
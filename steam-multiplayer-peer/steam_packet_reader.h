@@ -0,0 +1,49 @@
+#ifndef STEAM_PACKET_READER_H
+#define STEAM_PACKET_READER_H
+
+#include <godot_cpp/classes/multiplayer_peer.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+
+#include "steam_multiplayer_peer.h"
+
+using namespace godot;
+
+// Reads what SteamPacketWriter packs. Reading past the end returns zeroes and sets the
+// overflow flag, so a whole message can be decoded before checking is_overflowed() once.
+class SteamPacketReader : public RefCounted {
+	GDCLASS(SteamPacketReader, RefCounted)
+
+private:
+	Ref<SteamPacketPeer> packet; // the peer's own receive buffer, when read through read_next
+	PackedByteArray bytes;
+	const uint8_t *data = nullptr;
+	uint64_t bit_size = 0;
+	uint64_t bit_position = 0;
+	bool overflowed = false;
+
+protected:
+	static void _bind_methods();
+
+public:
+	Error read_next(const Ref<SteamMultiplayerPeer> &peer);
+	void set_data(const PackedByteArray &new_bytes);
+	void reset(const uint8_t *p_data, uint32_t p_size);
+	int32_t get_packet_peer() const;
+	MultiplayerPeer::TransferMode get_packet_mode() const;
+
+	uint64_t read_bits(int bits);
+	bool read_bool();
+	int64_t read_uint(int bits);
+	int64_t read_int(int bits);
+	int64_t read_varint();
+	int64_t read_enum(int count);
+	float read_float();
+	float read_quantized_float(float min, float max, int bits);
+	PackedByteArray read_bytes();
+	void align();
+
+	int64_t get_remaining_bits() const;
+	bool is_overflowed() const;
+};
+
+#endif // STEAM_PACKET_READER_H
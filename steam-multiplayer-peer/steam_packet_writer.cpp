@@ -0,0 +1,153 @@
+#include "steam_packet_writer.h"
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/math.hpp>
+
+void SteamPacketWriter::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("write_bool", "value"), &SteamPacketWriter::write_bool);
+	ClassDB::bind_method(D_METHOD("write_uint", "value", "bits"), &SteamPacketWriter::write_uint);
+	ClassDB::bind_method(D_METHOD("write_int", "value", "bits"), &SteamPacketWriter::write_int);
+	ClassDB::bind_method(D_METHOD("write_varint", "value"), &SteamPacketWriter::write_varint);
+	ClassDB::bind_method(D_METHOD("write_enum", "value", "count"), &SteamPacketWriter::write_enum);
+	ClassDB::bind_method(D_METHOD("write_float", "value"), &SteamPacketWriter::write_float);
+	ClassDB::bind_method(D_METHOD("write_quantized_float", "value", "min", "max", "bits"), &SteamPacketWriter::write_quantized_float);
+	ClassDB::bind_method(D_METHOD("write_bytes", "bytes"), &SteamPacketWriter::write_bytes);
+	ClassDB::bind_method(D_METHOD("align"), &SteamPacketWriter::align);
+	ClassDB::bind_method(D_METHOD("get_bit_size"), &SteamPacketWriter::get_bit_size);
+	ClassDB::bind_method(D_METHOD("get_byte_size"), &SteamPacketWriter::get_byte_size);
+	ClassDB::bind_method(D_METHOD("is_overflowed"), &SteamPacketWriter::is_overflowed);
+	ClassDB::bind_method(D_METHOD("get_data"), &SteamPacketWriter::get_data);
+	ClassDB::bind_method(D_METHOD("clear"), &SteamPacketWriter::clear);
+	ClassDB::bind_method(D_METHOD("commit", "peer", "target_peer", "mode"), &SteamPacketWriter::commit);
+}
+
+int SteamPacketWriter::bits_for_count(uint64_t count) {
+	int bits = 0;
+	while (count > 1 && ((count - 1) >> bits) != 0) {
+		bits++;
+	}
+	return bits;
+}
+
+void SteamPacketWriter::write_bits(uint64_t value, int bits) {
+	ERR_FAIL_COND(bits < 0 || bits > 64);
+	if (overflowed) {
+		return;
+	}
+	uint64_t byte_count = (bit_count + bits + 7) >> 3;
+	if (byte_count > MAX_STEAM_PACKET_SIZE) {
+		overflowed = true;
+		ERR_FAIL_MSG("Packet writer exceeded the maximum Steam packet size.");
+	}
+	uint32_t old_size = buffer.size();
+	if (byte_count > old_size) {
+		buffer.resize(byte_count);
+		memset(buffer.ptr() + old_size, 0, byte_count - old_size);
+	}
+	while (bits > 0) {
+		int offset = bit_count & 7;
+		int take = MIN(8 - offset, bits);
+		buffer[bit_count >> 3] |= (uint8_t)((value & ((1u << take) - 1)) << offset);
+		value >>= take;
+		bits -= take;
+		bit_count += take;
+	}
+}
+
+void SteamPacketWriter::write_bool(bool value) {
+	write_bits(value ? 1 : 0, 1);
+}
+
+void SteamPacketWriter::write_uint(int64_t value, int bits) {
+	ERR_FAIL_COND_MSG(bits < 64 && (uint64_t)value >> bits != 0, vformat("%d does not fit in %d unsigned bits.", value, bits));
+	write_bits((uint64_t)value, bits);
+}
+
+void SteamPacketWriter::write_int(int64_t value, int bits) {
+	ERR_FAIL_COND(bits < 1 || bits > 64);
+	ERR_FAIL_COND_MSG(bits < 64 && (value < -(INT64_C(1) << (bits - 1)) || value >= (INT64_C(1) << (bits - 1))), vformat("%d does not fit in %d signed bits.", value, bits));
+	write_bits((uint64_t)value & (bits == 64 ? UINT64_MAX : (UINT64_C(1) << bits) - 1), bits);
+}
+
+// Zigzag encoded, then 7 bits per group with a continuation bit, so small magnitudes of
+// either sign stay small.
+void SteamPacketWriter::write_varint(int64_t value) {
+	uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+	do {
+		uint64_t group = zigzag & 0x7F;
+		zigzag >>= 7;
+		write_bits(group | (zigzag != 0 ? 0x80 : 0), 8);
+	} while (zigzag != 0);
+}
+
+void SteamPacketWriter::write_enum(int64_t value, int count) {
+	ERR_FAIL_COND_MSG(value < 0 || value >= count, vformat("Enum value %d out of range for %d values.", value, count));
+	write_bits((uint64_t)value, bits_for_count(count));
+}
+
+void SteamPacketWriter::write_float(float value) {
+	uint32_t raw;
+	memcpy(&raw, &value, sizeof(raw));
+	write_bits(raw, 32);
+}
+
+// Maps [min, max] onto 2^bits - 1 evenly spaced steps, values outside the range are clamped.
+void SteamPacketWriter::write_quantized_float(float value, float min, float max, int bits) {
+	ERR_FAIL_COND(bits < 1 || bits > 32);
+	ERR_FAIL_COND(max <= min);
+	uint64_t steps = (UINT64_C(1) << bits) - 1;
+	double t = (CLAMP(value, min, max) - (double)min) / ((double)max - min);
+	write_bits((uint64_t)Math::round(t * steps), bits);
+}
+
+void SteamPacketWriter::write_bytes(const PackedByteArray &bytes) {
+	write_varint(bytes.size());
+	const uint8_t *r = bytes.ptr();
+	for (int64_t i = 0; i < bytes.size(); i++) {
+		write_bits(r[i], 8);
+	}
+}
+
+void SteamPacketWriter::align() {
+	if (bit_count & 7) {
+		write_bits(0, 8 - (bit_count & 7));
+	}
+}
+
+int64_t SteamPacketWriter::get_bit_size() const {
+	return bit_count;
+}
+
+int64_t SteamPacketWriter::get_byte_size() const {
+	return (bit_count + 7) >> 3;
+}
+
+bool SteamPacketWriter::is_overflowed() const {
+	return overflowed;
+}
+
+PackedByteArray SteamPacketWriter::get_data() const {
+	PackedByteArray data;
+	data.resize(get_byte_size());
+	memcpy(data.ptrw(), buffer.ptr(), data.size());
+	return data;
+}
+
+void SteamPacketWriter::clear() {
+	buffer.clear();
+	bit_count = 0;
+	overflowed = false;
+}
+
+// Copies the packed bits straight into a Steam message, see SteamMultiplayerPeer::begin_message.
+// The writer is left untouched, so the same contents can be committed to several targets.
+Error SteamPacketWriter::commit(const Ref<SteamMultiplayerPeer> &peer, int32_t target_peer, MultiplayerPeer::TransferMode mode) const {
+	ERR_FAIL_COND_V(peer.is_null(), ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V_MSG(overflowed, ERR_OUT_OF_MEMORY, "Packet writer overflowed, nothing sent.");
+	SteamNetworkingMessage_t *msg = nullptr;
+	int32_t size = get_byte_size();
+	uint8_t *w = peer->begin_message(size, mode, &msg);
+	ERR_FAIL_NULL_V(w, ERR_CANT_CREATE);
+	memcpy(w, buffer.ptr(), size);
+	return peer->commit_message(msg, target_peer);
+}
@@ -0,0 +1,49 @@
+#ifndef STEAM_PACKET_WRITER_H
+#define STEAM_PACKET_WRITER_H
+
+#include <godot_cpp/classes/multiplayer_peer.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+
+#include "steam_multiplayer_peer.h"
+
+using namespace godot;
+
+// Bit-level packet builder. Values are packed LSB first, with no padding between them. The
+// buffer keeps its allocation across clear() so one writer can be reused every frame.
+class SteamPacketWriter : public RefCounted {
+	GDCLASS(SteamPacketWriter, RefCounted)
+
+private:
+	LocalVector<uint8_t> buffer;
+	uint64_t bit_count = 0;
+	bool overflowed = false;
+
+protected:
+	static void _bind_methods();
+
+public:
+	void write_bits(uint64_t value, int bits);
+	void write_bool(bool value);
+	void write_uint(int64_t value, int bits);
+	void write_int(int64_t value, int bits);
+	void write_varint(int64_t value);
+	void write_enum(int64_t value, int count);
+	void write_float(float value);
+	void write_quantized_float(float value, float min, float max, int bits);
+	void write_bytes(const PackedByteArray &bytes);
+	void align();
+
+	int64_t get_bit_size() const;
+	int64_t get_byte_size() const;
+	bool is_overflowed() const;
+	PackedByteArray get_data() const;
+	const uint8_t *ptr() const { return buffer.ptr(); }
+	void clear();
+
+	Error commit(const Ref<SteamMultiplayerPeer> &peer, int32_t target_peer, MultiplayerPeer::TransferMode mode) const;
+
+	static int bits_for_count(uint64_t count);
+};
+
+#endif // STEAM_PACKET_WRITER_H
@@ -2,63 +2,126 @@
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
+// A copy, so edits through the getter can't skip the dirty flag.
 Dictionary SteamPeerConfig::get_options() const {
-	return options;
+	return options.duplicate();
 }
 
 int SteamPeerConfig::size() const {
 	return options.size();
 }
 
-SteamNetworkingConfigValue_t *SteamPeerConfig::get_convert_options() const {
-	int options_size = options.size();
-	SteamNetworkingConfigValue_t *option_array = new SteamNetworkingConfigValue_t[options_size];
-
-	if (options_size > 0) {
-		for (int i = 0; i < options_size; i++) {
-			SteamNetworkingConfigValue_t this_option;
-			int sent_option = (int)options.keys()[i];
-			UtilityFunctions::print(sent_option);
-			ESteamNetworkingConfigValue this_value = ESteamNetworkingConfigValue((int)sent_option);
-			Variant::Type type = options[sent_option].get_type();
-			if (type == Variant::INT) {
+void SteamPeerConfig::_compile() const {
+	if (!dirty) {
+		return;
+	}
+
+	compiled_options.clear();
+	compiled_strings.clear();
+	Array keys = options.keys();
+	compiled_options.reserve(keys.size());
+	// Reserved up front so the string buffers handed to Steam never move.
+	compiled_strings.reserve(keys.size());
+
+	for (int i = 0; i < keys.size(); i++) {
+		int sent_option = (int)keys[i];
+		ERR_CONTINUE_MSG(sent_option <= k_ESteamNetworkingConfig_Invalid || sent_option >= k_ESteamNetworkingConfigValue__Force32Bit, vformat("Invalid Steam networking config: %d", sent_option));
+		ESteamNetworkingConfigValue this_value = ESteamNetworkingConfigValue(sent_option);
+		Variant value = options[keys[i]];
+		SteamNetworkingConfigValue_t this_option;
+		switch (value.get_type()) {
+			case Variant::BOOL:
+			case Variant::INT:
 				if (sent_option == k_ESteamNetworkingConfig_ConnectionUserData) {
-					this_option.SetInt64(this_value, options[sent_option]);
+					this_option.SetInt64(this_value, (int64_t)value);
 				} else {
-					this_option.SetInt32(this_value, options[sent_option]);
+					this_option.SetInt32(this_value, (int32_t)value);
 				}
-			} else if (type == Variant::FLOAT) {
-				this_option.SetFloat(this_value, options[sent_option]);
-			} else if (type == Variant::STRING) {
-				char *this_string = { 0 };
-				String passed_string = options[sent_option];
-				strcpy(this_string, passed_string.utf8().get_data());
-				this_option.SetString(this_value, this_string);
-			} else {
-				Object *this_pointer;
-				this_pointer = options[sent_option];
-				this_option.SetPtr(this_value, this_pointer);
-			}
-			option_array[i] = this_option;
+				break;
+			case Variant::FLOAT:
+				this_option.SetFloat(this_value, (float)value);
+				break;
+			case Variant::STRING:
+			case Variant::STRING_NAME:
+				compiled_strings.push_back(String(value).utf8());
+				this_option.SetString(this_value, compiled_strings[compiled_strings.size() - 1].get_data());
+				break;
+			default:
+				ERR_CONTINUE_MSG(true, vformat("Unsupported value type for Steam networking config %d.", sent_option));
+		}
+		compiled_options.push_back(this_option);
+	}
+
+	dirty = false;
+}
+
+const SteamNetworkingConfigValue_t *SteamPeerConfig::get_compiled_options() const {
+	_compile();
+	return compiled_options.size() > 0 ? compiled_options.ptr() : nullptr;
+}
+
+int SteamPeerConfig::get_compiled_size() const {
+	_compile();
+	return compiled_options.size();
+}
+
+// Per connection state the peer owns: the slot stamped in the user data and the status callback.
+static bool _is_peer_owned_option(ESteamNetworkingConfigValue p_value) {
+	switch (p_value) {
+		case k_ESteamNetworkingConfig_ConnectionUserData:
+		case k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged:
+		case k_ESteamNetworkingConfig_Callback_AuthStatusChanged:
+		case k_ESteamNetworkingConfig_Callback_RelayNetworkStatusChanged:
+		case k_ESteamNetworkingConfig_Callback_MessagesSessionRequest:
+		case k_ESteamNetworkingConfig_Callback_MessagesSessionFailed:
+		case k_ESteamNetworkingConfig_Callback_CreateConnectionSignaling:
+		case k_ESteamNetworkingConfig_Callback_FakeIPResult:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Pushes the compiled options onto an already open connection. Options that Steam
+// only honours at creation time (virtual ports, symmetric connect...) are rejected.
+// User data and callbacks are skipped, overwriting them would cut the connection off
+// from its slot and from the hub.
+Error SteamPeerConfig::apply_to_connection(HSteamNetConnection connection) const {
+	ERR_FAIL_COND_V_MSG(SteamNetworkingUtils() == NULL, ERR_UNAVAILABLE, "SteamNetworkingUtils is null!");
+	ERR_FAIL_COND_V(connection == k_HSteamNetConnection_Invalid, ERR_INVALID_PARAMETER);
+	_compile();
+
+	Error result = OK;
+	for (uint32_t i = 0; i < compiled_options.size(); i++) {
+		if (_is_peer_owned_option(compiled_options[i].m_eValue)) {
+			continue;
+		}
+		if (!SteamNetworkingUtils()->SetConfigValueStruct(compiled_options[i], k_ESteamNetworkingConfig_Connection, connection)) {
+			WARN_PRINT(vformat("Steam networking config %d can't be applied to an open connection.", (int)compiled_options[i].m_eValue));
+			result = ERR_INVALID_PARAMETER;
 		}
 	}
-	return option_array;
+	return result;
 }
 
 void SteamPeerConfig::set_options(const Dictionary new_options) {
-	options = new_options;
+	options = new_options.duplicate();
+	dirty = true;
 }
 
 void SteamPeerConfig::clear_all_configs() {
 	options.clear();
+	dirty = true;
 }
 
 void SteamPeerConfig::set_config(const SteamNetworkingConfig config, Variant value) {
 	options[config] = value;
+	dirty = true;
 }
 
 void SteamPeerConfig::clear_config(const SteamNetworkingConfig config) {
 	options.erase(config);
+	dirty = true;
 }
 
 void SteamPeerConfig::_bind_methods() {
@@ -1,9 +1,10 @@
 #ifndef STEAM_PEER_CONFIG
 #define STEAM_PEER_CONFIG
 
-#include "steam/steam_api_flat.h"
+#include "steam_networking_api.h"
 #include <godot_cpp/classes/os.hpp>
 #include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
 
 using namespace godot;
 
@@ -12,7 +13,13 @@ class SteamPeerConfig : public RefCounted {
 
 private:
 	Dictionary options;
-	SteamNetworkingConfigValue_t *option_array;
+
+	// Validated snapshot of options in Steam's format, rebuilt when a setter marks it dirty.
+	// Strings referenced by the snapshot are owned by compiled_strings.
+	mutable LocalVector<SteamNetworkingConfigValue_t> compiled_options;
+	mutable LocalVector<CharString> compiled_strings;
+	mutable bool dirty = true;
+	void _compile() const;
 
 public:
 	// Networking Sockets enums
@@ -93,7 +100,9 @@ public:
 
 	Dictionary get_options() const;
 	int size() const;
-	SteamNetworkingConfigValue_t *get_convert_options() const;
+	const SteamNetworkingConfigValue_t *get_compiled_options() const;
+	int get_compiled_size() const;
+	Error apply_to_connection(HSteamNetConnection connection) const;
 	void set_options(const Dictionary new_options);
 	void set_config(const SteamNetworkingConfig config, Variant value);
 	void clear_config(const SteamNetworkingConfig config);
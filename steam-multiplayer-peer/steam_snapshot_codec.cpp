@@ -0,0 +1,203 @@
+#include "steam_snapshot_codec.h"
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/math.hpp>
+
+#define TRANSFORM_FLOATS 7
+#define COUNT_HEADER_SIZE 2
+#define QUAT_COMPONENT_MAX 0.70710678f // largest possible value of a non-largest component
+
+// Scalar code: quantize into a flat array of fields, then bit pack them with a 64 bit
+// accumulator. Decoding runs the same two passes in reverse.
+
+void SteamSnapshotCodec::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("encode", "transforms"), &SteamSnapshotCodec::encode);
+	ClassDB::bind_method(D_METHOD("decode", "payload"), &SteamSnapshotCodec::decode);
+	ClassDB::bind_method(D_METHOD("get_transform_bits"), &SteamSnapshotCodec::get_transform_bits);
+	ClassDB::bind_method(D_METHOD("set_position_min", "position_min"), &SteamSnapshotCodec::set_position_min);
+	ClassDB::bind_method(D_METHOD("get_position_min"), &SteamSnapshotCodec::get_position_min);
+	ClassDB::bind_method(D_METHOD("set_position_max", "position_max"), &SteamSnapshotCodec::set_position_max);
+	ClassDB::bind_method(D_METHOD("get_position_max"), &SteamSnapshotCodec::get_position_max);
+	ClassDB::bind_method(D_METHOD("set_position_bits", "bits"), &SteamSnapshotCodec::set_position_bits);
+	ClassDB::bind_method(D_METHOD("get_position_bits"), &SteamSnapshotCodec::get_position_bits);
+	ClassDB::bind_method(D_METHOD("set_rotation_bits", "bits"), &SteamSnapshotCodec::set_rotation_bits);
+	ClassDB::bind_method(D_METHOD("get_rotation_bits"), &SteamSnapshotCodec::get_rotation_bits);
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR3, "position_min"), "set_position_min", "get_position_min");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR3, "position_max"), "set_position_max", "get_position_max");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "position_bits"), "set_position_bits", "get_position_bits");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "rotation_bits"), "set_rotation_bits", "get_rotation_bits");
+}
+
+int32_t SteamSnapshotCodec::get_transform_bits() const {
+	return 3 * position_bits + 2 + 3 * rotation_bits;
+}
+
+PackedByteArray SteamSnapshotCodec::encode(const PackedFloat32Array &transforms) const {
+	PackedByteArray payload;
+	ERR_FAIL_COND_V_MSG(transforms.size() % TRANSFORM_FLOATS != 0, payload, "Transforms must be packed as 7 floats each.");
+	uint32_t count = transforms.size() / TRANSFORM_FLOATS;
+	ERR_FAIL_COND_V_MSG(count > UINT16_MAX, payload, "Too many transforms for one snapshot.");
+
+	quantized.resize(count * TRANSFORM_FLOATS);
+	const float *r = transforms.ptr();
+	uint32_t *q = quantized.ptr();
+
+	const float position_steps = (float)((1u << position_bits) - 1);
+	const float rotation_steps = (float)((1u << rotation_bits) - 1);
+	const float pmin[3] = { position_min.x, position_min.y, position_min.z };
+	const float pmax[3] = { position_max.x, position_max.y, position_max.z };
+	float pscale[3];
+	for (int a = 0; a < 3; a++) {
+		pscale[a] = position_steps / (pmax[a] - pmin[a]);
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		const float *t = r + i * TRANSFORM_FLOATS;
+		uint32_t *o = q + i * TRANSFORM_FLOATS;
+		for (int a = 0; a < 3; a++) {
+			float p = MIN(MAX(t[a], pmin[a]), pmax[a]);
+			o[a] = (uint32_t)((p - pmin[a]) * pscale[a] + 0.5f);
+		}
+
+		const float x = t[3], y = t[4], z = t[5], w = t[6];
+		const float ax = ABS(x), ay = ABS(y), az = ABS(z), aw = ABS(w);
+		// Index of the largest component.
+		uint32_t largest = 0;
+		float best = ax;
+		largest = ay > best ? 1 : largest;
+		best = MAX(best, ay);
+		largest = az > best ? 2 : largest;
+		best = MAX(best, az);
+		largest = aw > best ? 3 : largest;
+		// q and -q are the same rotation, flip so the dropped component is positive.
+		const float comps[4] = { x, y, z, w };
+		const float sign = comps[largest] < 0.0f ? -1.0f : 1.0f;
+		o[3] = largest;
+		for (int k = 0, j = 0; k < 4; k++) {
+			if (k == (int)largest) {
+				continue;
+			}
+			float c = MIN(MAX(comps[k] * sign, -QUAT_COMPONENT_MAX), QUAT_COMPONENT_MAX);
+			o[4 + j++] = (uint32_t)((c + QUAT_COMPONENT_MAX) * (rotation_steps / (2.0f * QUAT_COMPONENT_MAX)) + 0.5f);
+		}
+	}
+
+	const int32_t widths[TRANSFORM_FLOATS] = { position_bits, position_bits, position_bits, 2, rotation_bits, rotation_bits, rotation_bits };
+	uint64_t total_bits = (uint64_t)count * get_transform_bits();
+	payload.resize(COUNT_HEADER_SIZE + (total_bits + 7) / 8);
+	uint8_t *w = payload.ptrw();
+	w[0] = count & 0xFF;
+	w[1] = (count >> 8) & 0xFF;
+	w += COUNT_HEADER_SIZE;
+
+	uint64_t accumulator = 0;
+	int pending = 0;
+	for (uint32_t i = 0; i < count * TRANSFORM_FLOATS; i++) {
+		accumulator |= (uint64_t)q[i] << pending;
+		pending += widths[i % TRANSFORM_FLOATS];
+		while (pending >= 8) {
+			*w++ = accumulator & 0xFF;
+			accumulator >>= 8;
+			pending -= 8;
+		}
+	}
+	if (pending > 0) {
+		*w = accumulator & 0xFF;
+	}
+	return payload;
+}
+
+PackedFloat32Array SteamSnapshotCodec::decode(const PackedByteArray &payload) const {
+	PackedFloat32Array transforms;
+	ERR_FAIL_COND_V_MSG(payload.size() < COUNT_HEADER_SIZE, transforms, "Snapshot payload is truncated.");
+	const uint8_t *r = payload.ptr();
+	uint32_t count = r[0] | (r[1] << 8);
+	uint64_t total_bits = (uint64_t)count * get_transform_bits();
+	ERR_FAIL_COND_V_MSG((uint64_t)payload.size() < COUNT_HEADER_SIZE + (total_bits + 7) / 8, transforms, "Snapshot payload is truncated, or was encoded with different bit widths.");
+	r += COUNT_HEADER_SIZE;
+
+	quantized.resize(count * TRANSFORM_FLOATS);
+	uint32_t *q = quantized.ptr();
+	const int32_t widths[TRANSFORM_FLOATS] = { position_bits, position_bits, position_bits, 2, rotation_bits, rotation_bits, rotation_bits };
+	uint64_t accumulator = 0;
+	int available = 0;
+	for (uint32_t i = 0; i < count * TRANSFORM_FLOATS; i++) {
+		int width = widths[i % TRANSFORM_FLOATS];
+		while (available < width) {
+			accumulator |= (uint64_t)(*r++) << available;
+			available += 8;
+		}
+		q[i] = accumulator & ((UINT64_C(1) << width) - 1);
+		accumulator >>= width;
+		available -= width;
+	}
+
+	transforms.resize(count * TRANSFORM_FLOATS);
+	float *w = transforms.ptrw();
+	const float position_steps = (float)((1u << position_bits) - 1);
+	const float rotation_steps = (float)((1u << rotation_bits) - 1);
+	const float pmin[3] = { position_min.x, position_min.y, position_min.z };
+	float pscale[3] = {
+		(position_max.x - position_min.x) / position_steps,
+		(position_max.y - position_min.y) / position_steps,
+		(position_max.z - position_min.z) / position_steps,
+	};
+	const float rscale = 2.0f * QUAT_COMPONENT_MAX / rotation_steps;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const uint32_t *o = q + i * TRANSFORM_FLOATS;
+		float *t = w + i * TRANSFORM_FLOATS;
+		for (int a = 0; a < 3; a++) {
+			t[a] = pmin[a] + o[a] * pscale[a];
+		}
+		float a = o[4] * rscale - QUAT_COMPONENT_MAX;
+		float b = o[5] * rscale - QUAT_COMPONENT_MAX;
+		float c = o[6] * rscale - QUAT_COMPONENT_MAX;
+		float d = Math::sqrt(MAX(0.0f, 1.0f - a * a - b * b - c * c));
+		float comps[4];
+		uint32_t largest = o[3];
+		for (int k = 0, j = 0; k < 4; k++) {
+			comps[k] = k == (int)largest ? d : (j == 0 ? a : (j == 1 ? b : c));
+			j += k == (int)largest ? 0 : 1;
+		}
+		t[3] = comps[0];
+		t[4] = comps[1];
+		t[5] = comps[2];
+		t[6] = comps[3];
+	}
+	return transforms;
+}
+
+void SteamSnapshotCodec::set_position_min(const Vector3 &new_min) {
+	position_min = new_min;
+}
+
+Vector3 SteamSnapshotCodec::get_position_min() const {
+	return position_min;
+}
+
+void SteamSnapshotCodec::set_position_max(const Vector3 &new_max) {
+	position_max = new_max;
+}
+
+Vector3 SteamSnapshotCodec::get_position_max() const {
+	return position_max;
+}
+
+void SteamSnapshotCodec::set_position_bits(const int32_t new_bits) {
+	ERR_FAIL_COND_MSG(new_bits < 1 || new_bits > 24, "Position bits must be between 1 and 24.");
+	position_bits = new_bits;
+}
+
+int32_t SteamSnapshotCodec::get_position_bits() const {
+	return position_bits;
+}
+
+void SteamSnapshotCodec::set_rotation_bits(const int32_t new_bits) {
+	ERR_FAIL_COND_MSG(new_bits < 2 || new_bits > 16, "Rotation bits must be between 2 and 16.");
+	rotation_bits = new_bits;
+}
+
+int32_t SteamSnapshotCodec::get_rotation_bits() const {
+	return rotation_bits;
+}
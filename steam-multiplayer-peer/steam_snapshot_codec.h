@@ -0,0 +1,42 @@
+#ifndef STEAM_SNAPSHOT_CODEC_H
+#define STEAM_SNAPSHOT_CODEC_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/vector3.hpp>
+
+using namespace godot;
+
+// Packs arrays of transforms, 7 floats each (position xyz, rotation quaternion xyzw), into
+// a dense bitstream. Positions are range quantized, rotations use smallest-three encoding.
+// Both ends must use the same ranges and bit widths.
+class SteamSnapshotCodec : public RefCounted {
+	GDCLASS(SteamSnapshotCodec, RefCounted)
+
+private:
+	Vector3 position_min = Vector3(-1024, -1024, -1024);
+	Vector3 position_max = Vector3(1024, 1024, 1024);
+	int32_t position_bits = 16;
+	int32_t rotation_bits = 10;
+	// Quantized fields, 7 per transform: position xyz, largest component index, three components.
+	mutable LocalVector<uint32_t> quantized;
+
+protected:
+	static void _bind_methods();
+
+public:
+	PackedByteArray encode(const PackedFloat32Array &transforms) const;
+	PackedFloat32Array decode(const PackedByteArray &payload) const;
+	int32_t get_transform_bits() const;
+
+	void set_position_min(const Vector3 &new_min);
+	Vector3 get_position_min() const;
+	void set_position_max(const Vector3 &new_max);
+	Vector3 get_position_max() const;
+	void set_position_bits(const int32_t new_bits);
+	int32_t get_position_bits() const;
+	void set_rotation_bits(const int32_t new_bits);
+	int32_t get_rotation_bits() const;
+};
+
+#endif // STEAM_SNAPSHOT_CODEC_H
@@ -0,0 +1,62 @@
+#include "steam_trace.h"
+
+#include <godot_cpp/core/error_macros.hpp>
+
+#ifdef STEAM_PEER_TRACE_CHROME
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <atomic>
+#include <chrono>
+
+using namespace godot;
+
+struct SteamTraceEvent {
+	const char *name;
+	uint64_t start;
+	uint64_t duration;
+	int64_t value;
+};
+
+static SteamTraceEvent trace_ring[STEAM_TRACE_RING_SIZE];
+static std::atomic<uint64_t> trace_written{ 0 };
+
+static uint64_t _trace_now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SteamTraceZone::SteamTraceZone(const char *p_name) :
+		name(p_name), start(_trace_now()) {
+}
+
+SteamTraceZone::~SteamTraceZone() {
+	uint64_t index = trace_written.fetch_add(1, std::memory_order_relaxed);
+	SteamTraceEvent &event = trace_ring[index % STEAM_TRACE_RING_SIZE];
+	event.name = name;
+	event.start = start;
+	event.duration = _trace_now() - start;
+	event.value = value;
+}
+
+Error steam_trace_dump(const String &p_path) {
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE);
+	ERR_FAIL_COND_V_MSG(file.is_null(), ERR_CANT_OPEN, vformat("Cannot open %s for the network trace.", p_path));
+
+	uint64_t written = trace_written.load(std::memory_order_relaxed);
+	uint64_t first = written > STEAM_TRACE_RING_SIZE ? written - STEAM_TRACE_RING_SIZE : 0;
+	file->store_string("{\"traceEvents\":[\n");
+	for (uint64_t i = first; i < written; i++) {
+		const SteamTraceEvent &event = trace_ring[i % STEAM_TRACE_RING_SIZE];
+		file->store_string(vformat("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%d,\"dur\":%d,\"args\":{\"value\":%d}}%s\n",
+				event.name, (int64_t)event.start, (int64_t)event.duration, event.value, i + 1 < written ? "," : ""));
+	}
+	file->store_string("]}\n");
+	return OK;
+}
+
+#else
+
+godot::Error steam_trace_dump(const godot::String &p_path) {
+	ERR_FAIL_V_MSG(godot::ERR_UNAVAILABLE, "Built without network_trace=chrome.");
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef STEAM_TRACE_H
+#define STEAM_TRACE_H
+
+// Hot-path trace zones, compiled in only with `scons network_trace=chrome|tracy`.
+// STEAM_TRACE_ZONE opens a zone for the rest of the scope, STEAM_TRACE_VALUE attaches a count
+// or size to it. Without a sink both expand to nothing.
+
+#include <godot_cpp/classes/global_constants.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#if defined(STEAM_PEER_TRACE_TRACY)
+
+#include <tracy/Tracy.hpp>
+#define STEAM_TRACE_ZONE(m_name) ZoneScopedN(m_name)
+#define STEAM_TRACE_VALUE(m_value) ZoneValue((uint64_t)(m_value))
+
+#elif defined(STEAM_PEER_TRACE_CHROME)
+
+#include <cstdint>
+
+#define STEAM_TRACE_RING_SIZE 65536 // events, oldest are overwritten
+
+struct SteamTraceZone {
+	const char *name;
+	uint64_t start;
+	int64_t value = 0;
+	SteamTraceZone(const char *p_name);
+	~SteamTraceZone();
+};
+
+#define STEAM_TRACE_ZONE(m_name) SteamTraceZone _steam_trace_zone(m_name)
+#define STEAM_TRACE_VALUE(m_value) _steam_trace_zone.value = (int64_t)(m_value)
+
+#else
+
+#define STEAM_TRACE_ZONE(m_name)
+#define STEAM_TRACE_VALUE(m_value)
+
+#endif
+
+// Writes the chrome sink's ring buffer as chrome://tracing JSON. ERR_UNAVAILABLE in builds
+// without it.
+godot::Error steam_trace_dump(const godot::String &p_path);
+
+#endif // STEAM_TRACE_H
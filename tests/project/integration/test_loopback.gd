@@ -0,0 +1,132 @@
+extends "res://test_case.gd"
+## Host and client in one process over the IP transport on 127.0.0.1. Needs a build with
+## networking_backend=gns, or a Steam client; skipped when the sockets are unavailable.
+
+const PORT = 27115
+const TIMEOUT_MS = 5000
+
+
+func _poll_until(host: SteamMultiplayerPeer, client: SteamMultiplayerPeer, done: Callable) -> bool:
+	var deadline := Time.get_ticks_msec() + TIMEOUT_MS
+	while Time.get_ticks_msec() < deadline:
+		host.poll()
+		client.poll()
+		if done.call():
+			return true
+		await tree.process_frame
+	return false
+
+
+# Opens a host and a client, or records why not. Both are returned in either case.
+func _open(host: SteamMultiplayerPeer, client: SteamMultiplayerPeer, port: int) -> bool:
+	var host_err := host.create_host_ip("127.0.0.1", port)
+	if host_err == ERR_UNAVAILABLE:
+		skip("networking sockets unavailable, build with networking_backend=gns")
+		return false
+	check_eq(host_err, OK, "create_host_ip")
+	check_eq(client.create_client_ip("127.0.0.1", port), OK, "create_client_ip")
+	return failures.is_empty()
+
+
+func test_connect_and_exchange_packets() -> void:
+	var host := SteamMultiplayerPeer.new()
+	var client := SteamMultiplayerPeer.new()
+	if not _open(host, client, PORT):
+		return
+
+	var host_joined: Array[int] = []
+	var client_joined: Array[int] = []
+	host.peer_connected.connect(func(id: int): host_joined.append(id))
+	client.peer_connected.connect(func(id: int): client_joined.append(id))
+	var connected: bool = await _poll_until(host, client, func():
+		return client.get_connection_status() == MultiplayerPeer.CONNECTION_CONNECTED and host_joined.size() == 1)
+	check(connected, "client did not connect within %d ms" % TIMEOUT_MS)
+	if not connected:
+		return
+	check_eq(client_joined, [1], "client saw the host")
+	check(client.get_unique_id() > 1, "client got a peer id from the host")
+	check_eq(host_joined, [client.get_unique_id()], "host saw the client under its peer id")
+
+	client.transfer_mode = MultiplayerPeer.TRANSFER_MODE_RELIABLE
+	client.set_target_peer(1)
+	check_eq(client.put_packet(PackedByteArray([1, 2, 3, 4])), OK, "client put_packet")
+	check(await _poll_until(host, client, func(): return host.get_available_packet_count() > 0), "host received the packet")
+	if host.get_available_packet_count() > 0:
+		check_eq(host.get_packet_peer(), client.get_unique_id(), "packet sender")
+		check_eq(host.get_packet(), PackedByteArray([1, 2, 3, 4]), "packet payload")
+
+	host.transfer_mode = MultiplayerPeer.TRANSFER_MODE_RELIABLE
+	host.set_target_peer(client.get_unique_id())
+	check_eq(host.put_packet(PackedByteArray([5, 6])), OK, "host put_packet")
+	check(await _poll_until(host, client, func(): return client.get_available_packet_count() > 0), "client received the packet")
+	if client.get_available_packet_count() > 0:
+		check_eq(client.get_packet_peer(), 1, "packet sender")
+		check_eq(client.get_packet(), PackedByteArray([5, 6]), "packet payload")
+
+	client.close()
+	host.close()
+
+
+# The client's connection is lost and it redials from a new port. Both ends resume the parked
+# peer under its old id, and reliable packets queued meanwhile still arrive.
+func test_drop_and_resume() -> void:
+	if not ClassDB.class_exists("SteamPeerTests"):
+		skip("built without the tests option")
+		return
+	var helper = ClassDB.instantiate("SteamPeerTests")
+	var host := SteamMultiplayerPeer.new()
+	var client := SteamMultiplayerPeer.new()
+	host.reconnect_grace_time = TIMEOUT_MS
+	client.reconnect_grace_time = TIMEOUT_MS
+	if not _open(host, client, PORT + 1):
+		return
+
+	var events: Array[String] = []
+	host.peer_connected.connect(func(id: int): events.append("host connected %d" % id))
+	host.peer_disconnected.connect(func(id: int): events.append("host disconnected %d" % id))
+	host.peer_reconnecting.connect(func(id: int): events.append("host reconnecting %d" % id))
+	host.peer_resumed.connect(func(id: int): events.append("host resumed %d" % id))
+	client.peer_disconnected.connect(func(id: int): events.append("client disconnected %d" % id))
+	client.peer_reconnecting.connect(func(id: int): events.append("client reconnecting %d" % id))
+	client.peer_resumed.connect(func(id: int): events.append("client resumed %d" % id))
+	var connected: bool = await _poll_until(host, client, func():
+		return client.get_connection_status() == MultiplayerPeer.CONNECTION_CONNECTED and events.size() == 1)
+	check(connected, "client did not connect within %d ms" % TIMEOUT_MS)
+	if not connected:
+		return
+	var client_id := client.get_unique_id()
+	events.clear()
+
+	check_eq(helper.drop_connection(client, 1), OK, "drop_connection")
+	var parked: bool = await _poll_until(host, client, func(): return events.has("host reconnecting %d" % client_id))
+	check(parked, "host did not park the client")
+	if not parked:
+		return
+	check(events.has("client reconnecting 1"), "client parked the host")
+
+	host.transfer_mode = MultiplayerPeer.TRANSFER_MODE_RELIABLE
+	host.set_target_peer(client_id)
+	check_eq(host.put_packet(PackedByteArray([7])), OK, "host put_packet while parked")
+	client.transfer_mode = MultiplayerPeer.TRANSFER_MODE_RELIABLE
+	client.set_target_peer(1)
+	check_eq(client.put_packet(PackedByteArray([8])), OK, "client put_packet while parked")
+
+	var resumed: bool = await _poll_until(host, client, func():
+		return events.has("host resumed %d" % client_id) and events.has("client resumed 1"))
+	check(resumed, "peers did not resume within %d ms, events: %s" % [TIMEOUT_MS, events])
+	if not resumed:
+		return
+	check_eq(client.get_unique_id(), client_id, "client kept its peer id")
+	check_eq(events.size(), 4, "only reconnecting and resumed on each side, events: %s" % [events])
+
+	check(await _poll_until(host, client, func(): return host.get_available_packet_count() > 0 and client.get_available_packet_count() > 0), "queued packets arrived")
+	if host.get_available_packet_count() > 0:
+		check_eq(host.get_packet_peer(), client_id, "packet sender")
+		check_eq(host.get_packet(), PackedByteArray([8]), "client packet queued while parked")
+	if client.get_available_packet_count() > 0:
+		check_eq(client.get_packet(), PackedByteArray([7]), "host packet queued while parked")
+	check_eq(host.get_available_packet_count(), 0, "no control messages reached the host as data")
+	check_eq(client.get_available_packet_count(), 0, "no control messages reached the client as data")
+
+	client.close()
+	host.close()
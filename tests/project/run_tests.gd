@@ -0,0 +1,48 @@
+extends SceneTree
+## Runs every test_* method of the test_*.gd scripts in unit/ and integration/, then quits
+## with the number of failed tests as the exit code.
+##   godot --headless --path tests/project --script res://run_tests.gd
+
+const TEST_DIRS = ["res://unit", "res://integration"]
+
+
+func _initialize() -> void:
+	_run.call_deferred()
+
+
+func _run() -> void:
+	if not ClassDB.class_exists("SteamMultiplayerPeer"):
+		printerr("The extension is not loaded, build it with `scons test`.")
+		quit(1)
+		return
+
+	var passed := 0
+	var failed := 0
+	var skipped := 0
+	for dir in TEST_DIRS:
+		for file in DirAccess.get_files_at(dir):
+			if not file.begins_with("test_") or not file.ends_with(".gd"):
+				continue
+			var script: GDScript = load(dir.path_join(file))
+			for method in script.get_script_method_list():
+				var test_name: String = method["name"]
+				if not test_name.begins_with("test_"):
+					continue
+				var test = script.new()
+				test.tree = self
+				await test.call(test_name)
+				var label := "%s:%s" % [file, test_name]
+				if not test.failures.is_empty():
+					failed += 1
+					printerr("FAIL %s" % label)
+					for failure in test.failures:
+						printerr("    %s" % failure)
+				elif not test.skip_reason.is_empty():
+					skipped += 1
+					print("SKIP %s (%s)" % [label, test.skip_reason])
+				else:
+					passed += 1
+					print("ok   %s" % label)
+
+	print("%d passed, %d failed, %d skipped" % [passed, failed, skipped])
+	quit(failed)
@@ -0,0 +1,27 @@
+extends RefCounted
+## Base for the scripts in unit/ and integration/. run_tests.gd calls every test_* method on
+## a fresh instance and reports what the checks collected.
+
+var tree: SceneTree
+var failures: PackedStringArray = []
+var skip_reason := ""
+
+
+func check(condition: bool, message: String) -> void:
+	if not condition:
+		failures.append(message)
+
+
+func check_eq(actual: Variant, expected: Variant, message: String) -> void:
+	if actual != expected:
+		failures.append("%s: expected %s, got %s" % [message, expected, actual])
+
+
+func check_near(actual: float, expected: float, tolerance: float, message: String) -> void:
+	if absf(actual - expected) > tolerance:
+		failures.append("%s: expected %s within %s, got %s" % [message, expected, tolerance, actual])
+
+
+## Marks the test as not run, for things the current build cannot do.
+func skip(reason: String) -> void:
+	skip_reason = reason
@@ -0,0 +1,100 @@
+extends "res://test_case.gd"
+## SteamHistogram through the native SteamPeerTests helper. Reported percentiles are the top
+## of the value's bucket, so at most 1/16 above the exact value and never above the max.
+
+var helper # SteamPeerTests, untyped so the script parses in builds without it
+
+
+func _has_helper() -> bool:
+	if not ClassDB.class_exists("SteamPeerTests"):
+		skip("built without the tests option")
+		return false
+	helper = ClassDB.instantiate("SteamPeerTests")
+	return true
+
+
+func _range(from: int, to: int, scale := 1) -> PackedInt64Array:
+	var values := PackedInt64Array()
+	for i in range(from, to + 1):
+		values.append(i * scale)
+	return values
+
+
+func _check_percentile(reported: int, exact: int, label: String) -> void:
+	check(reported >= exact and reported <= exact + exact / 16, "%s: %d is not within 1/16 above %d" % [label, reported, exact])
+
+
+func test_percentiles() -> void:
+	if not _has_helper():
+		return
+	for scale in [1, 7, 1000003]:
+		var values := _range(1, 1000, scale)
+		var stats: Dictionary = helper.histogram_record(values)
+		check_eq(stats["count"], 1000, "count")
+		check_eq(stats["min"], scale, "min")
+		check_eq(stats["max"], 1000 * scale, "max")
+		check_near(stats["mean"], 500.5 * scale, 1e-6 * scale, "mean")
+		_check_percentile(stats["p50"], 500 * scale, "p50 x%d" % scale)
+		_check_percentile(stats["p90"], 900 * scale, "p90 x%d" % scale)
+		_check_percentile(stats["p99"], 990 * scale, "p99 x%d" % scale)
+		_check_percentile(stats["p999"], 999 * scale, "p999 x%d" % scale)
+		for fraction in [0.01, 0.25, 0.75]:
+			var exact: int = int(fraction * 1000 + 0.5) * scale
+			_check_percentile(helper.histogram_percentile(values, fraction), exact, "p%d x%d" % [fraction * 100, scale])
+
+
+func test_small_values_are_exact() -> void:
+	if not _has_helper():
+		return
+	var values := _range(0, 15)
+	check_eq(helper.histogram_percentile(values, 0.5), 7, "p50")
+	check_eq(helper.histogram_percentile(values, 1.0), 15, "p100")
+	check_eq(helper.histogram_percentile(values, 0.0), 0, "p0")
+
+
+func test_percentile_never_exceeds_max() -> void:
+	if not _has_helper():
+		return
+	var stats: Dictionary = helper.histogram_record(PackedInt64Array([1000]))
+	check_eq(stats["p50"], 1000, "p50 of one value")
+	check_eq(stats["p999"], 1000, "p999 of one value")
+
+
+func test_empty() -> void:
+	if not _has_helper():
+		return
+	var stats: Dictionary = helper.histogram_record(PackedInt64Array())
+	check_eq(stats["count"], 0, "count")
+	check_eq(stats["min"], 0, "min")
+	check_eq(stats["max"], 0, "max")
+	check_eq(stats["mean"], 0.0, "mean")
+	check_eq(stats["p99"], 0, "p99")
+
+
+func test_merge() -> void:
+	if not _has_helper():
+		return
+	var first := _range(1, 100)
+	var second := _range(1001, 1100)
+	var stats: Dictionary = helper.histogram_merge(first, second)
+	check_eq(stats["count"], 200, "count")
+	check_eq(stats["min"], 1, "min")
+	check_eq(stats["max"], 1100, "max")
+	check_near(stats["mean"], (50.5 + 1050.5) / 2.0, 1e-6, "mean")
+	_check_percentile(stats["p50"], 100, "p50")
+	_check_percentile(stats["p90"], 1080, "p90")
+
+	var combined := first.duplicate()
+	combined.append_array(second)
+	check_eq(stats, helper.histogram_record(combined), "merging matches recording everything in one")
+	check_eq(helper.histogram_merge(first, PackedInt64Array()), helper.histogram_record(first), "merging an empty histogram")
+	check_eq(helper.histogram_merge(PackedInt64Array(), second), helper.histogram_record(second), "merging into an empty histogram")
+
+
+func test_reset() -> void:
+	if not _has_helper():
+		return
+	var stats: Dictionary = helper.histogram_reset(PackedInt64Array([1000000, 2000000]), PackedInt64Array())
+	check_eq(stats, helper.histogram_record(PackedInt64Array()), "reset empties the histogram")
+	stats = helper.histogram_reset(PackedInt64Array([1, 1000000]), PackedInt64Array([3, 5]))
+	check_eq(stats, helper.histogram_record(PackedInt64Array([3, 5])), "reset forgets min, max and buckets")
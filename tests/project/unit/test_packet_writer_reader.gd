@@ -0,0 +1,137 @@
+extends "res://test_case.gd"
+## SteamPacketWriter and SteamPacketReader round trips through set_data.
+
+
+func _reader_for(writer: SteamPacketWriter) -> SteamPacketReader:
+	var reader := SteamPacketReader.new()
+	reader.set_data(writer.get_data())
+	return reader
+
+
+func test_round_trip() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_bool(true)
+	writer.write_uint(5, 3)
+	writer.write_int(-3, 4)
+	writer.write_varint(-1234567)
+	writer.write_enum(4, 5)
+	writer.write_float(3.25)
+	writer.write_bool(false)
+	writer.write_bytes(PackedByteArray([0, 255, 7]))
+	writer.write_uint(0x1FFFFFFFF, 33)
+	check(not writer.is_overflowed(), "writer overflowed")
+
+	var reader := _reader_for(writer)
+	check_eq(reader.read_bool(), true, "bool")
+	check_eq(reader.read_uint(3), 5, "uint")
+	check_eq(reader.read_int(4), -3, "int")
+	check_eq(reader.read_varint(), -1234567, "varint")
+	check_eq(reader.read_enum(5), 4, "enum")
+	check_eq(reader.read_float(), 3.25, "float")
+	check_eq(reader.read_bool(), false, "bool")
+	check_eq(reader.read_bytes(), PackedByteArray([0, 255, 7]), "bytes")
+	check_eq(reader.read_uint(33), 0x1FFFFFFFF, "wide uint")
+	check(not reader.is_overflowed(), "reader overflowed")
+	check(reader.get_remaining_bits() < 8, "only padding is left")
+
+
+func test_sizes_and_align() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_bool(true)
+	writer.write_uint(5, 3)
+	check_eq(writer.get_bit_size(), 4, "bits are packed without padding")
+	check_eq(writer.get_byte_size(), 1, "byte size rounds up")
+	writer.align()
+	check_eq(writer.get_bit_size(), 8, "align pads to the byte")
+	writer.align()
+	check_eq(writer.get_bit_size(), 8, "align on a byte boundary is a no-op")
+	writer.write_enum(0, 1)
+	check_eq(writer.get_bit_size(), 8, "a one value enum takes no bits")
+	writer.write_enum(2, 3)
+	check_eq(writer.get_bit_size(), 10, "a three value enum takes two bits")
+
+	writer.clear()
+	check_eq(writer.get_bit_size(), 0, "clear empties the writer")
+	writer.write_bool(true)
+	writer.align()
+	writer.write_uint(0xAB, 8)
+	var reader := _reader_for(writer)
+	check_eq(reader.read_bool(), true, "bool before align")
+	reader.align()
+	check_eq(reader.read_uint(8), 0xAB, "byte after align")
+
+
+func test_varint_sizes() -> void:
+	# Zigzag keeps small magnitudes of either sign in one byte.
+	var cases := {0: 1, 1: 1, -1: 1, 63: 1, -64: 1, 64: 2, -65: 2}
+	for value in cases:
+		var writer := SteamPacketWriter.new()
+		writer.write_varint(value)
+		check_eq(writer.get_byte_size(), cases[value], "varint size of %d" % value)
+		check_eq(_reader_for(writer).read_varint(), value, "varint %d" % value)
+
+
+func test_int64_extremes() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_int(-9223372036854775807 - 1, 64)
+	writer.write_int(9223372036854775807, 64)
+	writer.write_varint(-9223372036854775807 - 1)
+	writer.write_varint(9223372036854775807)
+	var reader := _reader_for(writer)
+	check_eq(reader.read_int(64), -9223372036854775807 - 1, "int64 min")
+	check_eq(reader.read_int(64), 9223372036854775807, "int64 max")
+	check_eq(reader.read_varint(), -9223372036854775807 - 1, "varint min")
+	check_eq(reader.read_varint(), 9223372036854775807, "varint max")
+	check(not reader.is_overflowed(), "reader overflowed")
+
+
+func test_quantized_float_error() -> void:
+	var bits := 10
+	var step := 20.0 / ((1 << bits) - 1)
+	var values := PackedFloat32Array([-10.0, -3.3, 0.0, 0.01, 7.77, 10.0])
+	var writer := SteamPacketWriter.new()
+	for value in values:
+		writer.write_quantized_float(value, -10.0, 10.0, bits)
+	writer.write_quantized_float(25.0, -10.0, 10.0, bits)
+	writer.write_quantized_float(-25.0, -10.0, 10.0, bits)
+	check_eq(writer.get_bit_size(), bits * (values.size() + 2), "quantized size")
+
+	var reader := _reader_for(writer)
+	for value in values:
+		check_near(reader.read_quantized_float(-10.0, 10.0, bits), value, step / 2.0 + 1e-5, "quantized %s" % value)
+	check_near(reader.read_quantized_float(-10.0, 10.0, bits), 10.0, 1e-5, "clamped to max")
+	check_near(reader.read_quantized_float(-10.0, 10.0, bits), -10.0, 1e-5, "clamped to min")
+
+
+func test_read_past_end_overflows() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_uint(0xFF, 8)
+	var reader := _reader_for(writer)
+	check_eq(reader.read_uint(8), 0xFF, "last byte")
+	check(not reader.is_overflowed(), "not overflowed at the end")
+	check_eq(reader.read_uint(1), 0, "reads past the end return zero")
+	check(reader.is_overflowed(), "overflowed past the end")
+	check_eq(reader.get_remaining_bits(), 0, "nothing left after an overflow")
+	check_eq(reader.read_float(), 0.0, "later reads return zero")
+
+	reader.set_data(PackedByteArray([1]))
+	check(not reader.is_overflowed(), "set_data clears the overflow flag")
+
+
+func test_truncated_bytes_overflow() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_bytes(PackedByteArray([1, 2, 3, 4]))
+	var data := writer.get_data()
+	data.resize(3)
+	var reader := SteamPacketReader.new()
+	reader.set_data(data)
+	check_eq(reader.read_bytes(), PackedByteArray(), "truncated bytes read as empty")
+	check(reader.is_overflowed(), "truncated bytes overflow")
+
+
+func test_enum_out_of_range_overflows() -> void:
+	var writer := SteamPacketWriter.new()
+	writer.write_uint(6, 3)
+	var reader := _reader_for(writer)
+	check_eq(reader.read_enum(5), 0, "out of range enum reads as zero")
+	check(reader.is_overflowed(), "out of range enum overflows")
@@ -0,0 +1,122 @@
+extends "res://test_case.gd"
+## SteamSnapshotCodec encode/decode against the quantization error bounds.
+
+const QUAT_COMPONENT_MAX = 0.70710678
+
+
+func _random_transforms(rng: RandomNumberGenerator, count: int, low: Vector3, high: Vector3) -> PackedFloat32Array:
+	var transforms := PackedFloat32Array()
+	for i in count:
+		var axis := Vector3(rng.randf_range(-1, 1), rng.randf_range(-1, 1), rng.randf_range(-1, 1))
+		if axis.is_zero_approx():
+			axis = Vector3.UP
+		var rotation := Quaternion(axis.normalized(), rng.randf_range(-TAU, TAU))
+		transforms.append_array([
+			rng.randf_range(low.x, high.x), rng.randf_range(low.y, high.y), rng.randf_range(low.z, high.z),
+			rotation.x, rotation.y, rotation.z, rotation.w,
+		])
+	return transforms
+
+
+func _check_positions(codec: SteamSnapshotCodec, transforms: PackedFloat32Array, decoded: PackedFloat32Array) -> void:
+	var steps := float((1 << codec.position_bits) - 1)
+	var extent := codec.position_max - codec.position_min
+	for i in transforms.size() / 7:
+		for a in 3:
+			# Half a step from rounding, plus float error at the range's magnitude.
+			var bound: float = extent[a] / steps / 2.0 + 1e-4
+			check_near(decoded[i * 7 + a], transforms[i * 7 + a], bound, "transform %d axis %d" % [i, a])
+
+
+func _check_rotations(codec: SteamSnapshotCodec, transforms: PackedFloat32Array, decoded: PackedFloat32Array) -> void:
+	# The three sent components are off by at most half a step. The rebuilt largest one is at
+	# least 0.5, which keeps its error near three times that, four with the second order term.
+	var step := 2.0 * QUAT_COMPONENT_MAX / ((1 << codec.rotation_bits) - 1)
+	var bound := 4.0 * step / 2.0 + 1e-5
+	for i in transforms.size() / 7:
+		var original := Quaternion(transforms[i * 7 + 3], transforms[i * 7 + 4], transforms[i * 7 + 5], transforms[i * 7 + 6])
+		var result := Quaternion(decoded[i * 7 + 3], decoded[i * 7 + 4], decoded[i * 7 + 5], decoded[i * 7 + 6])
+		check_near(result.length(), 1.0, bound, "transform %d is a unit quaternion" % i)
+		# q and -q are the same rotation, the codec may send either.
+		if original.dot(result) < 0.0:
+			result = -result
+		for k in 4:
+			check_near(result[k], original[k], bound, "transform %d component %d" % [i, k])
+
+
+func test_default_ranges() -> void:
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 1
+	var codec := SteamSnapshotCodec.new()
+	var transforms := _random_transforms(rng, 200, codec.position_min, codec.position_max)
+	var payload := codec.encode(transforms)
+	check_eq(payload.size(), 2 + ceili(200 * codec.get_transform_bits() / 8.0), "payload size")
+	var decoded := codec.decode(payload)
+	check_eq(decoded.size(), transforms.size(), "decoded size")
+	if decoded.size() == transforms.size():
+		_check_positions(codec, transforms, decoded)
+		_check_rotations(codec, transforms, decoded)
+
+
+func test_custom_widths() -> void:
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 2
+	for widths in [[8, 4], [12, 7], [24, 16]]:
+		var codec := SteamSnapshotCodec.new()
+		codec.position_min = Vector3(0, -5, -40)
+		codec.position_max = Vector3(10, 20, 40)
+		codec.position_bits = widths[0]
+		codec.rotation_bits = widths[1]
+		check_eq(codec.get_transform_bits(), 3 * widths[0] + 2 + 3 * widths[1], "transform bits")
+		# Odd counts leave a partial byte at the end of the payload.
+		var transforms := _random_transforms(rng, 37, codec.position_min, codec.position_max)
+		var decoded := codec.decode(codec.encode(transforms))
+		check_eq(decoded.size(), transforms.size(), "decoded size for %s" % [widths])
+		if decoded.size() == transforms.size():
+			_check_positions(codec, transforms, decoded)
+			_check_rotations(codec, transforms, decoded)
+
+
+func test_negative_largest_component() -> void:
+	var codec := SteamSnapshotCodec.new()
+	var rotation := Quaternion(0.1, -0.2, 0.3, -0.927362).normalized()
+	var transforms := PackedFloat32Array([1, 2, 3, rotation.x, rotation.y, rotation.z, rotation.w])
+	var decoded := codec.decode(codec.encode(transforms))
+	check_eq(decoded.size(), 7, "decoded size")
+	if decoded.size() == 7:
+		check(decoded[6] > 0.0, "the largest component is sent positive")
+		_check_rotations(codec, transforms, decoded)
+
+
+func test_positions_are_clamped() -> void:
+	var codec := SteamSnapshotCodec.new()
+	codec.position_min = Vector3(-1, -1, -1)
+	codec.position_max = Vector3(1, 1, 1)
+	var transforms := PackedFloat32Array([5, -5, 0, 0, 0, 0, 1])
+	var decoded := codec.decode(codec.encode(transforms))
+	check_eq(decoded.size(), 7, "decoded size")
+	if decoded.size() == 7:
+		check_near(decoded[0], 1.0, 1e-6, "clamped to max")
+		check_near(decoded[1], -1.0, 1e-6, "clamped to min")
+
+
+func test_empty_snapshot() -> void:
+	var codec := SteamSnapshotCodec.new()
+	var payload := codec.encode(PackedFloat32Array())
+	check_eq(payload, PackedByteArray([0, 0]), "only the count header")
+	check_eq(codec.decode(payload), PackedFloat32Array(), "decodes to nothing")
+
+
+func test_truncated_payload_is_rejected() -> void:
+	var rng := RandomNumberGenerator.new()
+	rng.seed = 3
+	var codec := SteamSnapshotCodec.new()
+	var payload := codec.encode(_random_transforms(rng, 4, codec.position_min, codec.position_max))
+	payload.resize(payload.size() - 1)
+	check_eq(codec.decode(payload), PackedFloat32Array(), "truncated payload")
+	check_eq(codec.decode(PackedByteArray([4])), PackedFloat32Array(), "truncated header")
+
+	var wider := SteamSnapshotCodec.new()
+	wider.position_bits = 20
+	payload = codec.encode(_random_transforms(rng, 4, codec.position_min, codec.position_max))
+	check_eq(wider.decode(payload), PackedFloat32Array(), "payload from narrower bit widths")
@@ -0,0 +1,66 @@
+#include "steam_peer_tests.h"
+
+#include <godot_cpp/core/class_db.hpp>
+
+#include "steam_histogram.h"
+
+void SteamPeerTests::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("histogram_record", "values"), &SteamPeerTests::histogram_record);
+	ClassDB::bind_method(D_METHOD("histogram_percentile", "values", "fraction"), &SteamPeerTests::histogram_percentile);
+	ClassDB::bind_method(D_METHOD("histogram_merge", "first", "second"), &SteamPeerTests::histogram_merge);
+	ClassDB::bind_method(D_METHOD("histogram_reset", "before", "after"), &SteamPeerTests::histogram_reset);
+	ClassDB::bind_method(D_METHOD("drop_connection", "peer", "peer_id"), &SteamPeerTests::drop_connection);
+}
+
+static void _record(SteamHistogram &r_histogram, const PackedInt64Array &p_values) {
+	for (int64_t i = 0; i < p_values.size(); i++) {
+		ERR_CONTINUE_MSG(p_values[i] < 0, "Histograms only record non-negative values.");
+		r_histogram.record(p_values[i]);
+	}
+}
+
+Dictionary SteamPeerTests::histogram_record(const PackedInt64Array &values) const {
+	SteamHistogram histogram;
+	_record(histogram, values);
+	return histogram.to_dictionary();
+}
+
+int64_t SteamPeerTests::histogram_percentile(const PackedInt64Array &values, double fraction) const {
+	SteamHistogram histogram;
+	_record(histogram, values);
+	return histogram.percentile(fraction);
+}
+
+Dictionary SteamPeerTests::histogram_merge(const PackedInt64Array &first, const PackedInt64Array &second) const {
+	SteamHistogram merged;
+	SteamHistogram other;
+	_record(merged, first);
+	_record(other, second);
+	merged.merge(other);
+	return merged.to_dictionary();
+}
+
+Dictionary SteamPeerTests::histogram_reset(const PackedInt64Array &before, const PackedInt64Array &after) const {
+	SteamHistogram histogram;
+	_record(histogram, before);
+	histogram.reset();
+	_record(histogram, after);
+	return histogram.to_dictionary();
+}
+
+Error SteamPeerTests::drop_connection(const Ref<SteamMultiplayerPeer> &peer, int32_t peer_id) const {
+	ERR_FAIL_COND_V(peer.is_null(), ERR_INVALID_PARAMETER);
+	HashMap<int32_t, uint32_t>::ConstIterator E = peer->slot_by_peer_id.find(peer_id);
+	ERR_FAIL_COND_V_MSG(!E, ERR_DOES_NOT_EXIST, vformat("No connection to peer %d.", peer_id));
+	HSteamNetConnection handle = peer->connection_slots[E->value].connection->steam_connection;
+	ERR_FAIL_COND_V_MSG(handle == k_HSteamNetConnection_Invalid, ERR_UNAVAILABLE, "The connection is already parked.");
+
+	SteamNetConnectionStatusChangedCallback_t event = {};
+	ERR_FAIL_COND_V(!SteamNetworkingSockets()->GetConnectionInfo(handle, &event.m_info), ERR_CANT_ACQUIRE_RESOURCE);
+	event.m_hConn = handle;
+	event.m_eOldState = event.m_info.m_eState;
+	event.m_info.m_eState = k_ESteamNetworkingConnectionState_ProblemDetectedLocally;
+	event.m_info.m_eEndReason = k_ESteamNetConnectionEnd_Misc_Timeout;
+	peer->status_events.push_back(event);
+	return OK;
+}
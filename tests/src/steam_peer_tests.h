@@ -0,0 +1,32 @@
+#ifndef STEAM_PEER_TESTS_H
+#define STEAM_PEER_TESTS_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+
+#include "steam_multiplayer_peer.h"
+
+using namespace godot;
+
+// Gives the scripts in tests/project access to native helpers that have no binding of their
+// own. Only compiled in with the tests SCons option.
+class SteamPeerTests : public RefCounted {
+	GDCLASS(SteamPeerTests, RefCounted)
+
+protected:
+	static void _bind_methods();
+
+public:
+	// SteamHistogram::to_dictionary after recording values.
+	Dictionary histogram_record(const PackedInt64Array &values) const;
+	int64_t histogram_percentile(const PackedInt64Array &values, double fraction) const;
+	// Records first and second into two histograms and merges second into first.
+	Dictionary histogram_merge(const PackedInt64Array &first, const PackedInt64Array &second) const;
+	// Records before, resets, then records after.
+	Dictionary histogram_reset(const PackedInt64Array &before, const PackedInt64Array &after) const;
+
+	// Makes peer's next poll see its connection to peer_id lost, as on a timeout.
+	Error drop_connection(const Ref<SteamMultiplayerPeer> &peer, int32_t peer_id) const;
+};
+
+#endif // STEAM_PEER_TESTS_H